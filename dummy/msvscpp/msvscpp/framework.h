@@ -2,4 +2,6 @@
 
 #define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
 // Windows Header Files
+#ifdef _WIN32
 #include <windows.h>
+#endif
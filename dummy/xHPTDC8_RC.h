@@ -17,6 +17,27 @@ static char ERR_MSG_INIT_FAILED_FMT[39] =		{ "xtdc8Manager initialization failed
 static char ERR_MSG_INVALID_ARGS[19] =			{ "Invalid arguments." };
 static char ERR_MSG_MEMORY_ALLOC[28] =			{ "Error in memory allocation." };
 static char ERR_MSG_DEVICE_NOT_READY_TRIG[39] = { "Device not ready for software trigger!" };
+static char ERR_MSG_GROUPING_ENABLED[44] =	{ "Function is not supported in grouping mode." };
+static char ERR_MSG_GROUPING_DISABLED[45] =	{ "Function is only supported in grouping mode." };
+static char ERR_MSG_RELEASE_EXCEEDS_VIEW[40] =	{ "Released hits exceed the acquired view." };
+static char ERR_MSG_INVALID_BUFFER_SIZE[21] =	{ "Invalid buffer size." };
+static char ERR_MSG_DEMUX_DISABLED[30] =		{ "Demultiplexer is not enabled." };
+static char ERR_MSG_INVALID_PACKET[41] =		{ "Packet was not returned by read_packets." };
+static char ERR_MSG_NUMA_BIND_FAILED[49] =	{ "Failed to bind the host buffer to the NUMA node." };
+static char ERR_MSG_HUGE_PAGES_FAILED[50] =	{ "Failed to allocate the host buffer in huge pages." };
+static char ERR_MSG_BUFFER_PAGES_NOT_SUPPORTED[47] =	{ "Page size of the host buffer is not supported." };
+static char ERR_MSG_LOCK_BUFFER_FAILED[42] =	{ "Failed to lock the host buffer in memory." };
+static char ERR_MSG_HIT_CALLBACK_REGISTERED[69] =	{ "Read functions are not supported while a hit callback is registered." };
+static char ERR_MSG_INVALID_WATERMARK[42] =	{ "Watermark exceeds host buffer or is zero." };
+static char ERR_MSG_EVENT_FD_FAILED[26] =		{ "Failed to create eventfd." };
+static char ERR_MSG_EVENT_FD_NOT_SUPPORTED[45] =	{ "Event descriptor is only supported on Linux." };
+static char ERR_MSG_INVALID_TIME_UNIT[48] =	{ "Invalid time_unit of the manager configuration." };
+static char ERR_MSG_GROUPING_TIME_UNIT[50] =	{ "Grouping requires time_unit XHPTDC8_TIME_UNIT_PS." };
+static char ERR_MSG_CONFIGURE_PENDING[31] =	{ "Configuration is not finished." };
+static char ERR_MSG_INVALID_CPU_MASK[40] =	{ "CPU mask does not contain a usable CPU." };
+static char ERR_MSG_SET_AFFINITY_FAILED[40] =	{ "Failed to set the CPUs of the thread." };
+static char ERR_MSG_INVALID_INIT_VERSION[49] =	{ "Version of the init parameters is not supported." };
+static char ERR_MSG_THREAD_START_FAILED[26] =	{ "Failed to start a thread." };
 
 #define XHPTDC8_MAN_MSG_ERR_NOT_INITIALIZED		"Manager not initialized!"
 
@@ -25,6 +46,7 @@ static char ERR_MSG_DEVICE_NOT_READY_TRIG[39] = { "Device not ready for software
 #define XHPTDC8_MAN_MSG_CONFIGURED			"configured"
 #define XHPTDC8_MAN_MSG_CAPTURING			"capturing"
 #define XHPTDC8_MAN_MSG_PAUSED				"paused"
+#define XHPTDC8_MAN_MSG_CONFIGURING			"configuring"
 
 #endif // !XHPTDC8_RESOURCE_H
 
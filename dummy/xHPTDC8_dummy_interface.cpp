@@ -6,11 +6,149 @@
 #include "xHPTDC8_dummy_interface.h"
 #include <random>
 #include "xHPTDC8_RC.h"
-#include <cstdarg>
-#include <Windows.h>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <system_error>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
 
 static std::default_random_engine g_generator; // Random engine generator
 static std::normal_distribution<double> g_distribution(5000.0, 30.0);
+
+/*
+* Event notification of xhptdc8_get_event_fd(), kept out of the manager as 
+* the manager is cleared by memset() in xhptdc8_init()
+*/
+static int g_event_fd = -1;
+static std::atomic<size_t> g_event_watermark(1);
+static std::atomic<uint64_t> g_event_read_count(0);	// Published dma_read_count
+static std::thread g_event_thread;
+static std::mutex g_event_mutex;
+static std::condition_variable g_event_cv;
+static bool g_event_thread_stop = false;	// Guarded by g_event_mutex
+static bool g_event_signaled = false;		// Guarded by g_event_mutex
+// DMA engine state when the event thread was started, see _fill_host_buffer_internal()
+static uint64_t g_event_base_write_count = 0;
+static int64_t g_event_base_fill_time = 0;
+static int64_t g_event_dma_read_delay = 0;
+static size_t g_event_buffer_hits = 0;
+
+/*
+* Queues of the demultiplexer, written by xhptdc8_demux_hits() and read by one 
+* thread per channel. The counters are on separate cache lines for the two threads.
+*/
+typedef struct {
+	TDCHit* hits;
+	alignas(64) std::atomic<uint64_t> write_count;
+	alignas(64) std::atomic<uint64_t> read_count;
+} dummy_channel_queue;
+// Including the queue XHPTDC8_DEMUX_OTHER_CHANNELS
+#define DUMMY_DEMUX_QUEUE_COUNT (XHPTDC8_DEMUX_CHANNEL_COUNT + 1)
+static dummy_channel_queue g_demux_queues[DUMMY_DEMUX_QUEUE_COUNT];
+static size_t g_demux_queue_hits = 0;	// Capacity of each queue, a power of 2, 0 if disabled
+
+/*
+* Hit callback of xhptdc8_register_hit_callback(). The reader thread moves the hits
+* from the host buffer to the callback ring, the callback thread passes them to the
+* callback.
+*/
+static xhptdc8_hit_callback g_callback = NULL;
+static void* g_callback_user_ctx = NULL;
+static size_t g_callback_batch_hits = 0;
+static TDCHit* g_callback_ring = NULL;
+static size_t g_callback_ring_hits = 0;	// A power of 2
+static std::atomic<uint64_t> g_callback_write_count(0);
+static std::atomic<uint64_t> g_callback_read_count(0);
+static std::atomic<uint64_t> g_callback_dropped_hits(0);
+static std::atomic<uint64_t> g_callback_calls(0);
+static std::atomic<uint64_t> g_callback_max_fill(0);
+static uint64_t g_reader_cpu_mask = 0;
+static uint64_t g_callback_cpu_mask = 0;
+static std::thread g_reader_thread;
+static std::thread g_callback_thread;
+static std::mutex g_callback_mutex;
+static std::condition_variable g_reader_cv;
+static std::condition_variable g_callback_cv;
+static bool g_reader_thread_stop = false;	// Guarded by g_callback_mutex
+static bool g_callback_thread_stop = false;	// Guarded by g_callback_mutex
+
+/*
+* Host time in nanoseconds at board time 0 of xhptdc8_get_current_timestamp(), set 
+* when the emulated DMA engine is restarted, -1 if not initialized. Read by any thread,
+* so it is checked instead of the manager state.
+*/
+static std::atomic<int64_t> g_timestamp_base_time(-1);
+
+/*
+* Counters of xhptdc8_get_readout_stats() since *_init(). The counters are added with
+* fetch_add, as the read functions may be called from any thread. The fill levels are
+* only stored by the thread writing the host buffer. Any thread reads them without a lock.
+*/
+typedef struct {
+	std::atomic<uint64_t> written_hits;
+	std::atomic<uint64_t> delivered_hits;
+	std::atomic<uint64_t> lost_hits_host_buffer_full;
+	std::atomic<uint64_t> lost_hits_callback_ring;
+	std::atomic<uint64_t> read_calls;
+	std::atomic<uint64_t> host_buffer_hits;
+	std::atomic<uint64_t> host_buffer_fill;
+	std::atomic<uint64_t> host_buffer_max_fill;
+} dummy_readout_stats;
+static dummy_readout_stats g_readout_stats;
+
+static inline void _add_readout_stat_internal(std::atomic<uint64_t>& counter, uint64_t value)
+{
+	counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+/*
+* Published dummy_status as a sequence lock: the writer makes g_status_sequence odd 
+* while it stores the words, readers retry if it was odd or changed meanwhile, so 
+* readers never wait for a lock and never delay the writer or the reader thread.
+*/
+#define DUMMY_STATUS_WORDS ((sizeof(dummy_status) + 7) / 8)
+static std::atomic<uint32_t> g_status_sequence(0);
+static std::atomic<uint64_t> g_status_words[DUMMY_STATUS_WORDS];
+static std::mutex g_status_write_mutex;	// Orders the writers, never taken by readers
+
+/*
+* Error of the last failing function of each thread, so threads reading hits and 
+* the control thread do not overwrite each other's message.
+*/
+static thread_local dummy_last_error g_last_error;
+
+/*
+* Configuration started by xhptdc8_configure_async(). The threads of the boards only
+* access the handle, the control thread applies the result to mngr.
+*/
+struct xhptdc8_configure_handle_ {
+	xhptdc8_manager_configuration config;
+	ManagerState::Enum previous_state;	// Restored if a board fails
+	std::thread board_threads[DUMMY_DEVICES_COUNT];
+	int board_results[DUMMY_DEVICES_COUNT];
+	std::atomic<int> pending_boards;
+	std::mutex mutex;
+	std::condition_variable finished_cv;
+	bool finished = false;	// Guarded by mutex
+	int event_fd = -1;		// Guarded by mutex, created by xhptdc8_get_configure_event_fd()
+	bool applied = false;	// Control thread only
+	int result = XHPTDC8_OK;
+};
+static xhptdc8_configure_handle* g_configure = NULL;	// Not applied yet, control thread only
+
 /**
 * Global variable of the manager
 */
@@ -73,10 +211,21 @@ extern "C" int xhptdc8_close()
 		_set_last_error_internal(ERR_MSG_DEVICE_NOT_INIT);
 		return XHPTDC8_WRONG_STATE;
 	}
+	// Boards must not be configured while the manager is closed
+	if (NULL != g_configure)
+	{
+		xhptdc8_configure_wait(g_configure, -1);
+	}
 	// make sure the device is no longer capturing data
 	xhptdc8_stop_capture(); //$$ not found in original driver code
+	_close_event_fd_internal();
+	xhptdc8_register_hit_callback(NULL, NULL, 0);
+	_free_demux_queues_internal();
+	_free_host_buffer_internal();
+	g_timestamp_base_time = -1;
 	mngr.state = ManagerState::UNINITIALIZED ; // CLOSED;
 	mngr.dev_state = DeviceState::CLOSED ;
+	_publish_status_internal();
 	return XHPTDC8_OK;
 }
 
@@ -97,6 +246,13 @@ extern "C" int xhptdc8_get_default_init_parameters(xhptdc8_manager_init_paramete
 	init->multiboard = 0;
 	init->use_ext_clock = 0; //0 use internal reference
 	init->ignore_calibration = 0;
+	init->buffer_pages = XHPTDC8_BUFFER_PAGES_DEFAULT;
+	init->lock_buffer = 0;
+	for (int device_index = 0; device_index < XHPTDC8_MANAGER_DEVICES_MAX; device_index++)
+	{
+		init->numa_node[device_index] = -1;
+		init->cpu_mask[device_index] = 0;
+	}
 
 	return XHPTDC8_OK;
 }
@@ -116,31 +272,78 @@ extern "C" int xhptdc8_get_default_init_parameters(xhptdc8_manager_init_paramete
 * - For demo purpose, we have only one device
 *
 */										 
-const static size_t MaxErrorMessageSize = 10000;
-static char lastErrorMessage[MaxErrorMessageSize];
 extern "C" int xhptdc8_init(xhptdc8_manager_init_parameters* params)
 {
 	CHECK_MANAGER_STATE(ManagerState::UNINITIALIZED);
 	if (nullptr == params)
 	{
-		snprintf(lastErrorMessage, MaxErrorMessageSize, ERR_MSG_INIT_FAILED_FMT, ERR_MSG_INVALID_ARGS);
+		_set_last_error_format_internal(ERR_MSG_INIT_FAILED_FMT, ERR_MSG_INVALID_ARGS, NULL, NULL);
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+
+	// Only the members known to the caller's version are read
+	xhptdc8_manager_init_parameters init_params;
+	if (XHPTDC8_OK != _copy_init_parameters_internal(params, &init_params))
+	{
+		_set_last_error_format_internal(ERR_MSG_INIT_FAILED_FMT, ERR_MSG_INVALID_INIT_VERSION, NULL, NULL);
 		return XHPTDC8_INVALID_ARGUMENTS;
 	}
 
+	for (int device_index = 0; device_index < XHPTDC8_MANAGER_DEVICES_MAX; device_index++)
+	{
+		if (!_is_valid_cpu_mask_internal(init_params.cpu_mask[device_index]))
+		{
+			_set_last_error_format_internal(ERR_MSG_INIT_FAILED_FMT, ERR_MSG_INVALID_CPU_MASK, NULL, NULL);
+			return XHPTDC8_INVALID_ARGUMENTS;
+		}
+	}
+
 	mngr.dev_state = DeviceState::CREATED;
-	lastErrorMessage[0] = 0;
+	_clear_last_error_internal();
 	memset(&mngr, 0, sizeof(xhptdc8_dummy_manager));
 	
 	// Initialize the structure
 	_init_static_info_internal(&(mngr.staticInfo));
 	memset(&(mngr.p_mgr_cfg), 0, sizeof(xhptdc8_manager_configuration));
-	int error_code = xhptdc8_get_default_init_parameters(&(mngr.params));
-	if (XHPTDC8_OK == error_code)
+	// Keep the caller's parameters, buffer_size defines the host buffer
+	mngr.params = init_params;
+	int error_code = _alloc_host_buffer_internal();
+	if (XHPTDC8_OK != error_code)
 	{
-		mngr.state = ManagerState::INITIALIZED ;
+		return error_code;
 	}
+	g_readout_stats.written_hits = 0;
+	g_readout_stats.delivered_hits = 0;
+	g_readout_stats.lost_hits_host_buffer_full = 0;
+	g_readout_stats.lost_hits_callback_ring = 0;
+	g_readout_stats.read_calls = 0;
+	g_readout_stats.host_buffer_hits = mngr.host_buffer_hits;
+	g_readout_stats.host_buffer_fill = 0;
+	g_readout_stats.host_buffer_max_fill = 0;
+	mngr.state = ManagerState::INITIALIZED ;
 	mngr.dev_state = DeviceState::INITIALIZED ;
+	_publish_status_internal();
+
+	return XHPTDC8_OK;
+}
+
+/*
+* Internal function to copy the init parameters of a caller built against an older API version.
+* Members added after the caller's version are set to their defaults. A version below 2 is read
+* as version 1.
+*/
+int _copy_init_parameters_internal(const xhptdc8_manager_init_parameters* params, xhptdc8_manager_init_parameters* init_params)
+{
+	if (params->version > XHPTDC8_API_VERSION)
+		return XHPTDC8_INVALID_ARGUMENTS;
 
+	size_t size = sizeof(xhptdc8_manager_init_parameters);
+	if (params->version < 2)
+		size = offsetof(xhptdc8_manager_init_parameters, buffer_pages);
+	else if (params->version < 3)
+		size = offsetof(xhptdc8_manager_init_parameters, numa_node);
+	xhptdc8_get_default_init_parameters(init_params);
+	memcpy(init_params, params, size);
 	return XHPTDC8_OK;
 }
 
@@ -186,11 +389,11 @@ extern "C" int xhptdc8_get_device_type(int index)
 }
 
 /*
-* Returns most recent error message.
+* Returns most recent error message of the calling thread.
 */
 extern "C" const char* xhptdc8_get_last_error_message(int index)
 {
-	return mngr.last_error_message;
+	return _format_last_error_internal();
 }
 
 /*
@@ -200,6 +403,7 @@ extern "C" const char* xhptdc8_get_last_error_message(int index)
 *
 * Specific to Dummy Library:
 * - For demo purpose, we have only one device, index is always 0
+* - The state is read from the published status, see dummy_status
 * 
 */
 extern "C" int xhptdc8_get_fast_info(int index, xhptdc8_fast_info* info)
@@ -209,6 +413,9 @@ extern "C" int xhptdc8_get_fast_info(int index, xhptdc8_fast_info* info)
 	if (nullptr == info)
 		return XHPTDC8_INVALID_ARGUMENTS;
 
+	dummy_status status;
+	_read_status_internal(&status);
+
 	info->size = sizeof(xhptdc8_fast_info);
 	info->version = XHPTDC8_FAST_INFO_VERSION;
 
@@ -217,7 +424,7 @@ extern "C" int xhptdc8_get_fast_info(int index, xhptdc8_fast_info* info)
 	info->pcie_pwr_mgmt = 0 ; // Always 0.
 	info->pcie_link_width = 1 ; // Should always be 1 for the xHPTDC8.
 	info->pcie_max_payload = 0 ;
-	info->state = XHPTDC8_DEVICE_STATE_CREATED; // Dummy value
+	info->state = status.dev_state;
 	
 	return XHPTDC8_OK;
 }
@@ -228,6 +435,7 @@ extern "C" int xhptdc8_get_fast_info(int index, xhptdc8_fast_info* info)
 *
 * Specific to Dummy Library:
 * - For demo purpose, we have only one device, index is always 0
+* - Read from the published status, see dummy_status
 *
 */
 extern "C" int xhptdc8_get_param_info(int index, xhptdc8_param_info* info)
@@ -235,11 +443,13 @@ extern "C" int xhptdc8_get_param_info(int index, xhptdc8_param_info* info)
 	if (nullptr == info)
 		return XHPTDC8_INVALID_ARGUMENTS;
 
-	if ((mngr.dev_state == DeviceState::CREATED) || (mngr.dev_state== DeviceState::INITIALIZED)) {
+	dummy_status status;
+	_read_status_internal(&status);
+	if ((status.dev_state == DeviceState::CREATED) || (status.dev_state== DeviceState::INITIALIZED)) {
 		// Error("Device is not configured, ParamInfo not yet available.");
 		return XHPTDC8_WRONG_STATE;
 	}
-	if (mngr.dev_state == DeviceState::CLOSED) {
+	if (status.dev_state == DeviceState::CLOSED) {
 		//Error("Device is already closed.");
 		return XHPTDC8_WRONG_STATE;
 	}
@@ -249,7 +459,9 @@ extern "C" int xhptdc8_get_param_info(int index, xhptdc8_param_info* info)
 	info->binsize = 1 / 76.8 * 1000.0;			// 13.0208333 ps
 	info->channels = XHPTDC8_TDC_CHANNEL_COUNT; // 8
 	info->channel_mask = 0;
-	info->total_buffer = 0;
+	info->total_buffer = status.total_buffer;
+	info->numa_node = status.numa_node;
+	info->cpu_mask = status.cpu_mask;
 
 	return XHPTDC8_OK;
 }
@@ -261,6 +473,7 @@ extern "C" int xhptdc8_get_param_info(int index, xhptdc8_param_info* info)
 *
 * Specific to Dummy Library:
 * - For demo purpose, we have only one device, index is always 0
+* - Read from the published status, see dummy_status
 *
 */
 extern "C" int xhptdc8_get_static_info (int index, xhptdc8_static_info* info)
@@ -270,7 +483,9 @@ extern "C" int xhptdc8_get_static_info (int index, xhptdc8_static_info* info)
 	if (nullptr == info)
 		return XHPTDC8_INVALID_ARGUMENTS;
 
-	*info = mngr.staticInfo;
+	dummy_status status;
+	_read_status_internal(&status);
+	*info = status.static_info;
 
 	return XHPTDC8_OK;
 }
@@ -321,6 +536,49 @@ extern "C" int xhptdc8_get_clock_info(int index, xhptdc8_clock_info* info)
 	return XHPTDC8_OK;
 }
 
+/*
+* Reads the PCIe link information.
+*
+* Specific to Dummy Library:
+* - The emulated link has the values of xhptdc8_get_fast_info() and never reports errors
+*
+*/
+extern "C" int xhptdc8_get_pcie_info(int index, crono_pcie_info* pcie_info)
+{
+	CHECK_VALID_DEVICE(index);
+
+	if (nullptr == pcie_info)
+		return XHPTDC8_INVALID_ARGUMENTS;
+
+	pcie_info->pwr_mgmt = 0;
+	pcie_info->link_width = 1;
+	pcie_info->max_payload = 0;
+	pcie_info->link_speed = 0;
+	pcie_info->error_status_supported = 0;
+	pcie_info->correctable_error_status = 0;
+	pcie_info->uncorrectable_error_status = 0;
+	pcie_info->reserved = 0;
+
+	return XHPTDC8_OK;
+}
+
+/*
+* Clears the PCIe error status, flags is a combination of CRONO_PCIE_*_FLAG.
+*
+* Specific to Dummy Library:
+* - There are no errors to clear
+*
+*/
+extern "C" int xhptdc8_clear_pcie_errors(int index, int flags)
+{
+	CHECK_VALID_DEVICE(index);
+
+	if (0 != (flags & ~(CRONO_PCIE_CORRECTABLE_FLAG | CRONO_PCIE_UNCORRECTABLE_FLAG)))
+		return XHPTDC8_INVALID_ARGUMENTS;
+
+	return XHPTDC8_OK;
+}
+
 /*
 */
 extern "C" const char* xhptdc8_device_state_to_str(int state)
@@ -349,21 +607,141 @@ extern "C" const char* xhptdc8_device_state_to_str(int state)
 //
 
 /*
-* Configures the xHPTDC8 manager.
+* Configures the xHPTDC8 manager and waits for the boards.
 */
 extern "C" int xhptdc8_configure(xhptdc8_manager_configuration* mgr_cfg)
 {
-	if (nullptr == mgr_cfg)
+	xhptdc8_configure_handle* handle;
+	int error_code = xhptdc8_configure_async(mgr_cfg, &handle);
+	if (XHPTDC8_OK != error_code)
+	{
+		return error_code;
+	}
+	error_code = xhptdc8_configure_wait(handle, -1);
+	xhptdc8_release_configure(handle);
+	return error_code;
+}
+
+/*
+* Starts a thread per board configuring it, see _configure_board_internal().
+* The manager is CONFIGURING until the control thread applies the result in 
+* _apply_configure_internal().
+*/
+extern "C" int xhptdc8_configure_async(xhptdc8_manager_configuration* mgr_cfg, xhptdc8_configure_handle** handle)
+{
+	if (nullptr == mgr_cfg || nullptr == handle)
 		return XHPTDC8_INVALID_ARGUMENTS;
 
 	CHECK_MANAGER_STATE_OR(ManagerState::INITIALIZED, ManagerState::CONFIGURED);
-	mngr.state = ManagerState::CONFIGURED;
+	if (XHPTDC8_TIME_UNIT_PS != mgr_cfg->time_unit && XHPTDC8_TIME_UNIT_BINS != mgr_cfg->time_unit)
+	{
+		_set_last_error_internal(ERR_MSG_INVALID_TIME_UNIT);
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+	if (XHPTDC8_TIME_UNIT_BINS == mgr_cfg->time_unit && mgr_cfg->grouping.enabled)
+	{
+		_set_last_error_internal(ERR_MSG_GROUPING_TIME_UNIT);
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
 
+	xhptdc8_configure_handle* configure;
+	try {
+		configure = new xhptdc8_configure_handle;
+	}
+	catch (std::bad_alloc& ba) {
+		fprintf(stdout, "Exception in memory allocation: %s", ba.what());
+		_set_last_error_internal(ERR_MSG_MEMORY_ALLOC);
+		return XHPTDC8_BUFFER_ALLOC_FAILED;
+	}
 	// Copy the structure, don't do '=', as the caller might release its memory at any time
-	memcpy(&(mngr.p_mgr_cfg), mgr_cfg, sizeof(xhptdc8_manager_configuration));
+	memcpy(&(configure->config), mgr_cfg, sizeof(xhptdc8_manager_configuration));
+	configure->previous_state = mngr.state;
+	configure->pending_boards = DUMMY_DEVICES_COUNT;
+	xhptdc8_configure_handle* previous_configure = g_configure;
+	mngr.state = ManagerState::CONFIGURING;
+	g_configure = configure;
+	for (int device_index = 0; device_index < DUMMY_DEVICES_COUNT; device_index++)
+	{
+		try {
+			configure->board_threads[device_index] = std::thread(_configure_board_internal, configure, device_index);
+		}
+		catch (std::system_error&) {
+			// The boards already started finish, then the configuration is discarded
+			for (int started_index = 0; started_index < device_index; started_index++)
+			{
+				configure->board_threads[started_index].join();
+			}
+			mngr.state = configure->previous_state;
+			g_configure = previous_configure;
+			delete configure;
+			_set_last_error_internal(ERR_MSG_THREAD_START_FAILED);
+			return XHPTDC8_INTERNAL_ERROR;
+		}
+	}
+	*handle = configure;
+
+	return XHPTDC8_OK;
+}
+
+extern "C" int xhptdc8_configure_wait(xhptdc8_configure_handle* handle, int64_t timeout_ns)
+{
+	if (nullptr == handle)
+		return XHPTDC8_INVALID_ARGUMENTS;
+
+	if (!handle->applied)
+	{
+		std::unique_lock<std::mutex> lock(handle->mutex);
+		if (timeout_ns < 0)
+		{
+			handle->finished_cv.wait(lock, [handle] { return handle->finished; });
+		}
+		else if (!handle->finished_cv.wait_for(lock, std::chrono::nanoseconds(timeout_ns),
+			[handle] { return handle->finished; }))
+		{
+			return XHPTDC8_INSUFFICIENT_DATA;
+		}
+	}
+	return _apply_configure_internal(handle);
+}
+
+extern "C" int xhptdc8_get_configure_event_fd(xhptdc8_configure_handle* handle, int* event_fd)
+{
+	if (nullptr == handle || nullptr == event_fd)
+		return XHPTDC8_INVALID_ARGUMENTS;
+
+#ifdef __linux__
+	std::lock_guard<std::mutex> lock(handle->mutex);
+	if (handle->event_fd < 0)
+	{
+		handle->event_fd = eventfd(handle->finished ? 1 : 0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (handle->event_fd < 0)
+		{
+			_set_last_error_internal(ERR_MSG_EVENT_FD_FAILED);
+			return XHPTDC8_INTERNAL_ERROR;
+		}
+	}
+	*event_fd = handle->event_fd;
 
-	// For *_configure() you just return the status code and ignore the configuration.
 	return XHPTDC8_OK;
+#else
+	_set_last_error_internal(ERR_MSG_EVENT_FD_NOT_SUPPORTED);
+	return XHPTDC8_INTERNAL_ERROR;
+#endif
+}
+
+extern "C" void xhptdc8_release_configure(xhptdc8_configure_handle* handle)
+{
+	if (nullptr == handle)
+		return;
+
+	xhptdc8_configure_wait(handle, -1);
+#ifdef __linux__
+	if (handle->event_fd >= 0)
+	{
+		close(handle->event_fd);
+	}
+#endif
+	delete handle;
 }
 
 /*
@@ -439,6 +817,9 @@ extern "C" int xhptdc8_get_default_configuration(xhptdc8_manager_configuration *
 	config->grouping.enabled = false;
 	
 	//config->bin_to_ps = NULL;
+	config->time_unit = XHPTDC8_TIME_UNIT_PS;
+	for (int channel = 0; channel < XHPTDC8_CHANNEL_OFFSET_COUNT; channel++)
+		config->channel_offset[channel] = 0;
 
 	return XHPTDC8_OK;
 }
@@ -466,7 +847,11 @@ extern "C" int xhptdc8_get_current_configuration(xhptdc8_manager_configuration *
 */
 extern "C" int xhptdc8_start_capture()
 {
-	if (mngr.dev_state == DeviceState::CREATED || mngr.dev_state == ManagerState::INITIALIZED) {
+	if (ManagerState::CONFIGURING == mngr.state) {
+		_set_last_error_internal(ERR_MSG_CONFIGURE_PENDING);
+		return XHPTDC8_WRONG_STATE;
+	}
+	if (mngr.dev_state == DeviceState::CREATED || mngr.dev_state == DeviceState::INITIALIZED) {
 		_set_last_error_internal(ERR_MSG_DEVICE_NOT_CONF);
 		return XHPTDC8_WRONG_STATE;
 	}
@@ -483,13 +868,32 @@ extern "C" int xhptdc8_start_capture()
 		return XHPTDC8_WRONG_STATE;
 	}
 
-	SYSTEMTIME time;
-	GetSystemTime(&time);
-	mngr.start_capture_time = (time.wSecond * 1000) + time.wMilliseconds;
-	mngr.captured_stored_time = 0;
+	if (_has_hit_callback_internal() && mngr.p_mgr_cfg.grouping.enabled)
+	{
+		_set_last_error_internal(ERR_MSG_GROUPING_ENABLED);
+		return XHPTDC8_WRONG_STATE;
+	}
+
 	mngr.read_hits_count = 0;
-	mngr.last_read_time = 0;
+	_reset_host_buffer_internal();
+	g_callback_write_count = 0;
+	g_callback_read_count = 0;
+	g_callback_dropped_hits = 0;
+	g_callback_calls = 0;
+	g_callback_max_fill = 0;
+	int error_code = _start_event_thread_internal();
+	if (XHPTDC8_OK == error_code)
+	{
+		error_code = _start_callback_threads_internal();
+	}
+	if (XHPTDC8_OK != error_code)
+	{
+		_stop_event_thread_internal();
+		return error_code;
+	}
+	mngr.state = ManagerState::CAPTURING;
 	mngr.dev_state = DeviceState::CAPTURING;
+	_publish_status_internal();
 
 	return XHPTDC8_OK;
 }
@@ -505,13 +909,14 @@ extern "C" int xhptdc8_pause_capture()
 		return XHPTDC8_WRONG_STATE;
 	}
 
-	SYSTEMTIME time;
-	GetSystemTime(&time);
-	mngr.captured_stored_time += (((time.wSecond * 1000) + time.wMilliseconds) -
-		mngr.start_capture_time) ;
-	mngr.start_capture_time = 0 ;
+	_stop_callback_threads_internal();
+	// Keep the hits written before the pause
+	_fill_host_buffer_internal();
+	_stop_event_thread_internal();
 
 	mngr.state = ManagerState::PAUSED;
+	mngr.dev_state = DeviceState::PAUSED;
+	_publish_status_internal();
 	return XHPTDC8_OK;
 }
 
@@ -527,11 +932,22 @@ extern "C" int xhptdc8_continue_capture()
 		return XHPTDC8_WRONG_STATE;
 	}
 
-	SYSTEMTIME time;
-	GetSystemTime(&time);
-	mngr.start_capture_time = (time.wSecond * 1000) + time.wMilliseconds;
+	// The DMA engine does not emulate the time being paused
+	mngr.dma_fill_time = _get_time_ns_internal() - _get_dma_read_delay_ns_internal();
+	int error_code = _start_event_thread_internal();
+	if (XHPTDC8_OK == error_code)
+	{
+		error_code = _start_callback_threads_internal();
+	}
+	if (XHPTDC8_OK != error_code)
+	{
+		_stop_event_thread_internal();
+		return error_code;
+	}
 
 	mngr.state = ManagerState::CAPTURING;
+	mngr.dev_state = DeviceState::CAPTURING;
+	_publish_status_internal();
 	return XHPTDC8_OK;
 }
 
@@ -547,17 +963,20 @@ extern "C" int xhptdc8_stop_capture()
 		return XHPTDC8_WRONG_STATE;
 	}
 	*/
-
-	if (ManagerState::CAPTURING == mngr.state)
-	{
-		SYSTEMTIME time;
-		GetSystemTime(&time);
-		mngr.captured_stored_time += (((time.wSecond * 1000) + time.wMilliseconds) -
-			mngr.start_capture_time);
-		mngr.start_capture_time = 0;
+	if (ManagerState::CONFIGURING == mngr.state) {
+		_set_last_error_internal(ERR_MSG_CONFIGURE_PENDING);
+		return XHPTDC8_WRONG_STATE;
 	}
 
+	_stop_callback_threads_internal();
+	_stop_event_thread_internal();
+
 	mngr.state = ManagerState::CONFIGURED;
+	if (DeviceState::CAPTURING == mngr.dev_state || DeviceState::PAUSED == mngr.dev_state)
+	{
+		mngr.dev_state = DeviceState::CONFIGURED;
+	}
+	_publish_status_internal();
 	return XHPTDC8_OK;
 }
 
@@ -631,22 +1050,17 @@ extern "C" int xhptdc8_read_hits(TDCHit* hit_buf, size_t size)
 		return XHPTDC8_WRONG_STATE;
 	}
 
-	mngr.read_hits_count++;
+	CHECK_NO_HIT_CALLBACK();
+	_count_read_call_internal();
 
 	if ( mngr.p_mgr_cfg.grouping.enabled )
 	{
-		int ret = _read_hits_for_groups_internal(hit_buf, size);
-		switch (ret)
+		xhptdc8_group_desc group;
+		if (0 == _read_hits_for_groups_internal(hit_buf, size, &group, NULL, 1))
 		{
-		case 2:
-			return 2;
-			break;
-		case 0:
-		case -1:
-		default:
-			_set_last_error_internal(ERR_MSG_BUFFER_SIZE_SMALL);
-			return ret ;
+			return 0;
 		}
+		return int(group.length);
 	}
 	else
 	// Grouping is not enabled
@@ -654,155 +1068,2236 @@ extern "C" int xhptdc8_read_hits(TDCHit* hit_buf, size_t size)
 		return _read_hits_for_NO_groups_internal(hit_buf, size);
 	}
 }
-#include <cinttypes>
 /*
-*  xhptdc8_read_hits when groups are note enabled
+* Returns a view of the hits available in the host buffer without copying them.
 */
-int _read_hits_for_NO_groups_internal(TDCHit* hit_buf, size_t size)
+extern "C" int xhptdc8_acquire_hits(const TDCHit** view, size_t* count)
 {
-	// Calculate ms_since_last_call
-	SYSTEMTIME time;
-	GetSystemTime(&time);
-	long current_timestamp = (time.wSecond * 1000) + time.wMilliseconds;
-	int64_t ms_since_last_call = current_timestamp - mngr.last_read_time;
-	mngr.last_read_time = current_timestamp;
-
-	// Calculate normal
-	int normal;
-
-	// Fill the hits
-	size_t max_hits_number = ((ms_since_last_call * 2) < (size)) ? (ms_since_last_call * 2) : (size);
-	for (int64_t hit_index = 0; hit_index < max_hits_number; hit_index += 2) /*2 as we fill couples of entries every time*/
+	if (nullptr == view || nullptr == count)
 	{
-		normal = int(g_distribution(g_generator)); // for each hit_index, a new random shall be computed.
-		hit_buf[hit_index    ].time = (ms_since_last_call + hit_index) * 1000000000;
-		hit_buf[hit_index + 1].time = (ms_since_last_call + hit_index) * 1000000000 + normal;
-		hit_buf[hit_index    ].channel = 0;
-		hit_buf[hit_index + 1].channel = 1;
-		hit_buf[hit_index    ].type = XHPTDC8_TDCHIT_TYPE_RISING;
-		hit_buf[hit_index + 1].type = XHPTDC8_TDCHIT_TYPE_RISING;
-		hit_buf[hit_index    ].bin = 0;
-		hit_buf[hit_index + 1].bin = 0;
+		return XHPTDC8_INVALID_ARGUMENTS;
 	}
-	return int(max_hits_number);
-}
 
-/*
-* xhptdc8_read_hits when groups are enabled
-* Return 3: Successfully filled hit_buf
-*		 0: Error, buffer is smaller than milliseconds
-*		-1: Error, buffer size is smaller than 2
-*/
-int _read_hits_for_groups_internal(TDCHit * hit_buf, size_t size)
-{
-	SYSTEMTIME time;
-	GetSystemTime(&time);
-	long current_timestamp = (time.wSecond * 1000) + time.wMilliseconds;
-	int64_t ms_since_last_call = current_timestamp - mngr.captured_stored_time;
-	if (mngr.read_hits_count < ms_since_last_call)
-	// The number of calls is less than the number of milliseconds elapsed since 
-	// the call to *_start_capture().
+	if (mngr.state != ManagerState::CAPTURING)
 	{
-		if (size < 3)
-		{
-			return -1;
-		}
-		int normal = int(g_distribution(g_generator));
-
-		hit_buf[0].time = mngr.read_hits_count * 1000000000;
-		hit_buf[1].time = 0;
-		hit_buf[2].time = normal;
-		hit_buf[1].channel = 255;
-		hit_buf[1].channel = 0;
-		hit_buf[2].channel = 1;
-		hit_buf[0].type = XHPTDC8_TDCHIT_TYPE_RISING;
-		hit_buf[1].type = XHPTDC8_TDCHIT_TYPE_RISING;
-		hit_buf[2].type = XHPTDC8_TDCHIT_TYPE_RISING;
-		hit_buf[0].bin = 0;
-		hit_buf[1].bin = 0;
-		hit_buf[2].bin = 0;
-
-		return 3;
+		_set_last_error_internal(ERR_MSG_DEVICE_IS_NOT_CAPURING);
+		return XHPTDC8_WRONG_STATE;
 	}
-	else
+
+	if (mngr.p_mgr_cfg.grouping.enabled)
 	{
-		return 0;
+		_set_last_error_internal(ERR_MSG_GROUPING_ENABLED);
+		return XHPTDC8_WRONG_STATE;
 	}
-}
 
-int xhptdc8_read_user_flash(int index, uint8_t* flash_data, uint32_t size)
-{
-	CHECK_VALID_DEVICE(index);
+	CHECK_NO_HIT_CALLBACK();
+	_count_read_call_internal();
+	_fill_host_buffer_internal();
+	*count = _get_host_buffer_view_internal(view);
+	mngr.acquired_hits = *count;
 
-	if (nullptr == flash_data)
-		return XHPTDC8_INVALID_ARGUMENTS;
+	return XHPTDC8_OK;
+}
 
-	if (size <= 0 )
+/*
+* Returns hits of the acquired view to the host buffer.
+*/
+extern "C" int xhptdc8_release_hits(size_t count)
+{
+	if (count > mngr.acquired_hits)
+	{
+		_set_last_error_internal(ERR_MSG_RELEASE_EXCEEDS_VIEW);
 		return XHPTDC8_INVALID_ARGUMENTS;
-
-	if (NULL != mngr.user_flash) {
-		memcpy(flash_data, mngr.user_flash,
-			mngr.user_flash_size > size ? size : mngr.user_flash_size);
-		if (mngr.user_flash_size < size)
-			size = mngr.user_flash_size;
 	}
 
+	mngr.acquired_hits -= count;
+	_advance_read_position_internal(count);
+
 	return XHPTDC8_OK;
 }
 
-int xhptdc8_write_user_flash(int index, uint8_t* flash_data, uint32_t size)
+/*
+* Sleeps until at least min_hits are available in the host buffer or the timeout expires.
+*/
+extern "C" int xhptdc8_wait_for_hits(size_t min_hits, int64_t timeout_ns)
 {
-	CHECK_VALID_DEVICE(index);
-
-	if (nullptr == flash_data)
-		return XHPTDC8_INVALID_ARGUMENTS;
-
-	if (size <= 0)
+	if (timeout_ns < 0)
+	{
 		return XHPTDC8_INVALID_ARGUMENTS;
+	}
 
-	if (NULL != mngr.user_flash) {
-		delete mngr.user_flash;
-		mngr.user_flash = NULL;
+	if (mngr.state != ManagerState::CAPTURING)
+	{
+		_set_last_error_internal(ERR_MSG_DEVICE_IS_NOT_CAPURING);
+		return XHPTDC8_WRONG_STATE;
 	}
-	try {
-		mngr.user_flash = new unsigned char[size];
+
+	if (mngr.p_mgr_cfg.grouping.enabled)
+	{
+		_set_last_error_internal(ERR_MSG_GROUPING_ENABLED);
+		return XHPTDC8_WRONG_STATE;
 	}
-	catch (std::bad_alloc& ba) {
-		fprintf(stdout, "Exception in memory allocation: %s", ba.what());
-		_set_last_error_internal(ERR_MSG_MEMORY_ALLOC);
+
+	if (min_hits > mngr.host_buffer_hits)
+	{
+		_set_last_error_internal(ERR_MSG_BUFFER_SIZE_SMALL);
 		return XHPTDC8_INVALID_ARGUMENTS;
 	}
-	memcpy(mngr.user_flash, flash_data, size);
-	mngr.user_flash_size = size;
+	CHECK_NO_HIT_CALLBACK();
 
-	return XHPTDC8_OK;
+	int64_t deadline = _get_time_ns_internal() + timeout_ns;
+	while (true)
+	{
+		_fill_host_buffer_internal();
+		size_t available_hits = (size_t)(mngr.dma_write_count - mngr.dma_read_count);
+		if (available_hits >= min_hits)
+		{
+			return XHPTDC8_OK;
+		}
+
+		int64_t now = _get_time_ns_internal();
+		if (now >= deadline)
+		{
+			return XHPTDC8_INSUFFICIENT_DATA;
+		}
+
+		// Sleep until the emulated DMA engine has written the missing hits, two
+		// hits per millisecond, and has updated the write pointer
+		int64_t missing_ms = (int64_t)((min_hits - available_hits + 1) / 2);
+		int64_t wake_up = mngr.dma_fill_time + missing_ms * 1000000 + _get_dma_read_delay_ns_internal();
+		std::this_thread::sleep_for(std::chrono::nanoseconds(((wake_up < deadline) ? wake_up : deadline) - now));
+	}
 }
 
-extern "C" int xhptdc8_software_trigger(int index) 
+/*
+* Returns the eventfd signaled when the available hits reach the watermark.
+*/
+extern "C" int xhptdc8_get_event_fd(int* event_fd)
 {
-	CHECK_VALID_DEVICE(index);
-	if ((mngr.dev_state != DeviceState::CREATED) || (mngr.dev_state != DeviceState::CLOSED))
+	if (nullptr == event_fd)
 	{
-		_set_last_error_internal(ERR_MSG_DEVICE_NOT_READY_TRIG);
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+
+	if (ManagerState::UNINITIALIZED == mngr.state)
+	{
+		_set_last_error_internal(ERR_MSG_DEVICE_NOT_INIT);
 		return XHPTDC8_WRONG_STATE;
 	}
-	return XHPTDC8_OK;
-}
+
+#ifdef __linux__
+	if (g_event_fd < 0)
+	{
+		g_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (g_event_fd < 0)
+		{
+			_set_last_error_internal(ERR_MSG_EVENT_FD_FAILED);
+			return XHPTDC8_INTERNAL_ERROR;
+		}
+		if (ManagerState::CAPTURING == mngr.state)
+		{
+			int error_code = _start_event_thread_internal();
+			if (XHPTDC8_OK != error_code)
+			{
+				_close_event_fd_internal();
+				return error_code;
+			}
+		}
+	}
+	*event_fd = g_event_fd;
+
+	return XHPTDC8_OK;
+#else
+	_set_last_error_internal(ERR_MSG_EVENT_FD_NOT_SUPPORTED);
+	return XHPTDC8_INTERNAL_ERROR;
+#endif
+}
+
+/*
+* Sets the number of available hits at which the eventfd is signaled.
+*/
+extern "C" int xhptdc8_set_event_watermark(size_t watermark_hits)
+{
+	if (ManagerState::UNINITIALIZED == mngr.state)
+	{
+		_set_last_error_internal(ERR_MSG_DEVICE_NOT_INIT);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	if (0 == watermark_hits || watermark_hits > mngr.host_buffer_hits)
+	{
+		_set_last_error_internal(ERR_MSG_INVALID_WATERMARK);
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+
+	{
+		// Let the event thread recalculate its wake-up time
+		std::lock_guard<std::mutex> lock(g_event_mutex);
+		g_event_watermark = watermark_hits;
+	}
+	g_event_cv.notify_one();
+
+	return XHPTDC8_OK;
+}
+
+/*
+* Passes up to size hits available in the host buffer to copy_hits(view, offset, count)
+* in contiguous segments, offset is the number of hits passed before the segment.
+* The hits are removed from the host buffer. Returns the number of hits.
+*/
+template <typename CopyFunction>
+size_t _drain_host_buffer_internal(size_t size, CopyFunction copy_hits)
+{
+	_fill_host_buffer_internal();
+
+	// Copying hits invalidates an acquired view
+	mngr.acquired_hits = 0;
+
+	size_t read_hits = 0;
+	while (read_hits < size)
+	{
+		const TDCHit* view;
+		size_t available_hits = _get_host_buffer_view_internal(&view);
+		if (0 == available_hits)
+		{
+			break;
+		}
+		size_t segment_hits = (available_hits < (size - read_hits)) ? available_hits : (size - read_hits);
+		copy_hits(view, read_hits, segment_hits);
+		_advance_read_position_internal(segment_hits);
+		read_hits += segment_hits;
+	}
+	return read_hits;
+}
+
+/*
+*  xhptdc8_read_hits when groups are note enabled
+*  Copies the hits written by the emulated DMA engine from the host buffer.
+*/
+int _read_hits_for_NO_groups_internal(TDCHit* hit_buf, size_t size)
+{
+	return int(_drain_host_buffer_internal(size,
+		[hit_buf](const TDCHit* view, size_t offset, size_t count) {
+			memcpy(hit_buf + offset, view, count * sizeof(TDCHit));
+		}));
+}
+
+/*
+* Read hits into separate arrays per field.
+*/
+extern "C" int xhptdc8_read_hits_soa(int64_t* time, uint8_t* channel, uint8_t* type, uint16_t* bin, size_t max)
+{
+	if (mngr.state != ManagerState::CAPTURING)
+	{
+		_set_last_error_internal(ERR_MSG_DEVICE_IS_NOT_CAPURING);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	if (mngr.p_mgr_cfg.grouping.enabled)
+	{
+		_set_last_error_internal(ERR_MSG_GROUPING_ENABLED);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	CHECK_NO_HIT_CALLBACK();
+	_count_read_call_internal();
+
+	return int(_drain_host_buffer_internal(max,
+		[=](const TDCHit* view, size_t offset, size_t count) {
+			// One pass per column keeps the loops vectorizable
+			if (nullptr != time)
+			{
+				for (size_t hit_index = 0; hit_index < count; hit_index++)
+					time[offset + hit_index] = view[hit_index].time;
+			}
+			if (nullptr != channel)
+			{
+				for (size_t hit_index = 0; hit_index < count; hit_index++)
+					channel[offset + hit_index] = view[hit_index].channel;
+			}
+			if (nullptr != type)
+			{
+				for (size_t hit_index = 0; hit_index < count; hit_index++)
+					type[offset + hit_index] = view[hit_index].type;
+			}
+			if (nullptr != bin)
+			{
+				for (size_t hit_index = 0; hit_index < count; hit_index++)
+					bin[offset + hit_index] = view[hit_index].bin;
+			}
+		}));
+}
+
+/*
+* Read hits in the packed format, starting with an anchor.
+*/
+extern "C" int xhptdc8_read_hits_packed(uint64_t* word_buf, size_t max_words)
+{
+	if (nullptr == word_buf || max_words < 2)
+	{
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+
+	if (mngr.state != ManagerState::CAPTURING)
+	{
+		_set_last_error_internal(ERR_MSG_DEVICE_IS_NOT_CAPURING);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	if (mngr.p_mgr_cfg.grouping.enabled)
+	{
+		_set_last_error_internal(ERR_MSG_GROUPING_ENABLED);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	CHECK_NO_HIT_CALLBACK();
+	_count_read_call_internal();
+	_fill_host_buffer_internal();
+	mngr.acquired_hits = 0;
+
+	size_t word_count = 0;
+	int64_t previous_time = 0;
+	while (true)
+	{
+		const TDCHit* view;
+		size_t available_hits = _get_host_buffer_view_internal(&view);
+		size_t hit_index = 0;
+		for (; hit_index < available_hits; hit_index++)
+		{
+			int64_t delta = view[hit_index].time - previous_time;
+			bool needs_anchor = (0 == word_count) || (delta < 0) || (delta > (int64_t)XHPTDC8_PACKED_MAX_DELTA);
+			if (word_count + (needs_anchor ? 2 : 1) > max_words)
+			{
+				break;
+			}
+			if (needs_anchor)
+			{
+				word_buf[word_count++] = XHPTDC8_PACKED_ANCHOR(view[hit_index].time);
+				delta = 0;
+			}
+			word_buf[word_count++] = XHPTDC8_PACKED_HIT(view[hit_index].channel, view[hit_index].type,
+				view[hit_index].bin, delta);
+			previous_time = view[hit_index].time;
+		}
+		_advance_read_position_internal(hit_index);
+		if (0 == available_hits || hit_index < available_hits)
+		{
+			break;
+		}
+	}
+	return int(word_count);
+}
+
+/*
+* Read the hits of the channels in channel_mask, other hits are discarded.
+*/
+extern "C" int xhptdc8_read_hits_masked(TDCHit* hit_buf, size_t read_max, uint64_t channel_mask, size_t* skipped)
+{
+	if (nullptr == hit_buf)
+	{
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+
+	if (mngr.state != ManagerState::CAPTURING)
+	{
+		_set_last_error_internal(ERR_MSG_DEVICE_IS_NOT_CAPURING);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	if (mngr.p_mgr_cfg.grouping.enabled)
+	{
+		_set_last_error_internal(ERR_MSG_GROUPING_ENABLED);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	CHECK_NO_HIT_CALLBACK();
+	_count_read_call_internal();
+	_fill_host_buffer_internal();
+	mngr.acquired_hits = 0;
+
+	size_t read_hits = 0;
+	size_t skipped_hits = 0;
+	while (read_hits < read_max)
+	{
+		const TDCHit* view;
+		size_t available_hits = _get_host_buffer_view_internal(&view);
+		if (0 == available_hits)
+		{
+			break;
+		}
+		size_t hit_index = 0;
+		for (; hit_index < available_hits && read_hits < read_max; hit_index++)
+		{
+			if (view[hit_index].channel < 64 && ((channel_mask >> view[hit_index].channel) & 1))
+			{
+				hit_buf[read_hits++] = view[hit_index];
+			}
+			else
+			{
+				skipped_hits++;
+			}
+		}
+		_advance_read_position_internal(hit_index);
+	}
+	if (nullptr != skipped)
+	{
+		*skipped = skipped_hits;
+	}
+	return int(read_hits);
+}
+
+/*
+* Allocates the queues of the demultiplexer.
+*/
+extern "C" int xhptdc8_enable_demux(size_t hits_per_channel)
+{
+	if (ManagerState::UNINITIALIZED == mngr.state)
+	{
+		_set_last_error_internal(ERR_MSG_DEVICE_NOT_INIT);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	if (ManagerState::CAPTURING == mngr.state || ManagerState::PAUSED == mngr.state)
+	{
+		_set_last_error_internal(ERR_MSG_DEVICE_IS_CAPTURING);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	_free_demux_queues_internal();
+	if (0 == hits_per_channel)
+	{
+		return XHPTDC8_OK;
+	}
+
+	size_t queue_hits = 1;
+	while (queue_hits < hits_per_channel)
+	{
+		queue_hits <<= 1;
+		if (0 == queue_hits)
+		{
+			_set_last_error_internal(ERR_MSG_INVALID_BUFFER_SIZE);
+			return XHPTDC8_INVALID_ARGUMENTS;
+		}
+	}
+	for (int channel = 0; channel < DUMMY_DEMUX_QUEUE_COUNT; channel++)
+	{
+		try {
+			g_demux_queues[channel].hits = new TDCHit[queue_hits];
+		}
+		catch (std::bad_alloc& ba) {
+			fprintf(stdout, "Exception in memory allocation: %s", ba.what());
+			_free_demux_queues_internal();
+			_set_last_error_internal(ERR_MSG_MEMORY_ALLOC);
+			return XHPTDC8_BUFFER_ALLOC_FAILED;
+		}
+		g_demux_queues[channel].write_count = 0;
+		g_demux_queues[channel].read_count = 0;
+	}
+	g_demux_queue_hits = queue_hits;
+
+	return XHPTDC8_OK;
+}
+
+/*
+* Moves the hits from the host buffer to the queues of their channels.
+*/
+extern "C" int xhptdc8_demux_hits()
+{
+	if (mngr.state != ManagerState::CAPTURING)
+	{
+		_set_last_error_internal(ERR_MSG_DEVICE_IS_NOT_CAPURING);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	if (mngr.p_mgr_cfg.grouping.enabled)
+	{
+		_set_last_error_internal(ERR_MSG_GROUPING_ENABLED);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	if (0 == g_demux_queue_hits)
+	{
+		_set_last_error_internal(ERR_MSG_DEMUX_DISABLED);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	CHECK_NO_HIT_CALLBACK();
+	_count_read_call_internal();
+	_fill_host_buffer_internal();
+	mngr.acquired_hits = 0;
+
+	// Work on local copies of the counters and publish them once at the end
+	uint64_t write_counts[DUMMY_DEMUX_QUEUE_COUNT];
+	uint64_t read_counts[DUMMY_DEMUX_QUEUE_COUNT];
+	for (int channel = 0; channel < DUMMY_DEMUX_QUEUE_COUNT; channel++)
+	{
+		write_counts[channel] = g_demux_queues[channel].write_count.load(std::memory_order_relaxed);
+		read_counts[channel] = g_demux_queues[channel].read_count.load(std::memory_order_acquire);
+	}
+	size_t queue_mask = g_demux_queue_hits - 1;
+
+	size_t demuxed_hits = 0;
+	bool queue_full = false;
+	while (!queue_full)
+	{
+		const TDCHit* view;
+		size_t available_hits = _get_host_buffer_view_internal(&view);
+		if (0 == available_hits)
+		{
+			break;
+		}
+		size_t hit_index = 0;
+		for (; hit_index < available_hits; hit_index++)
+		{
+			int channel = view[hit_index].channel;
+			if (channel >= XHPTDC8_DEMUX_CHANNEL_COUNT)
+			{
+				channel = XHPTDC8_DEMUX_OTHER_CHANNELS;
+			}
+			if (write_counts[channel] - read_counts[channel] == g_demux_queue_hits)
+			{
+				read_counts[channel] = g_demux_queues[channel].read_count.load(std::memory_order_acquire);
+				if (write_counts[channel] - read_counts[channel] == g_demux_queue_hits)
+				{
+					queue_full = true;
+					break;
+				}
+			}
+			g_demux_queues[channel].hits[write_counts[channel] & queue_mask] = view[hit_index];
+			write_counts[channel]++;
+		}
+		_advance_read_position_internal(hit_index);
+		demuxed_hits += hit_index;
+	}
+
+	for (int channel = 0; channel < DUMMY_DEMUX_QUEUE_COUNT; channel++)
+	{
+		g_demux_queues[channel].write_count.store(write_counts[channel], std::memory_order_release);
+	}
+	return int(demuxed_hits);
+}
+
+/*
+* Reads the hits from the queue of a channel. Lock-free, does not access the manager.
+*/
+extern "C" int xhptdc8_read_channel_hits(int channel, TDCHit* hit_buf, size_t read_max)
+{
+	if (nullptr == hit_buf || channel < 0 || channel > XHPTDC8_DEMUX_OTHER_CHANNELS)
+	{
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+
+	if (0 == g_demux_queue_hits)
+	{
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	dummy_channel_queue* queue = &(g_demux_queues[channel]);
+	uint64_t read_count = queue->read_count.load(std::memory_order_relaxed);
+	uint64_t available_hits = queue->write_count.load(std::memory_order_acquire) - read_count;
+	size_t read_hits = (available_hits < read_max) ? (size_t)available_hits : read_max;
+
+	// Copy in up to two segments as the queue wraps around
+	size_t read_index = (size_t)(read_count & (g_demux_queue_hits - 1));
+	size_t first_hits = g_demux_queue_hits - read_index;
+	if (first_hits > read_hits)
+	{
+		first_hits = read_hits;
+	}
+	memcpy(hit_buf, queue->hits + read_index, first_hits * sizeof(TDCHit));
+	memcpy(hit_buf + first_hits, queue->hits, (read_hits - first_hits) * sizeof(TDCHit));
+	queue->read_count.store(read_count + read_hits, std::memory_order_release);
+
+	return int(read_hits);
+}
+
+/*
+* Returns the packets written to the packet buffer.
+*/
+extern "C" int xhptdc8_read_packets(volatile crono_packet** first_packet, volatile crono_packet** last_packet)
+{
+	if (nullptr == first_packet || nullptr == last_packet)
+	{
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+
+	if (mngr.state != ManagerState::CAPTURING)
+	{
+		_set_last_error_internal(ERR_MSG_DEVICE_IS_NOT_CAPURING);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	if (mngr.p_mgr_cfg.grouping.enabled)
+	{
+		_set_last_error_internal(ERR_MSG_GROUPING_ENABLED);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	CHECK_NO_HIT_CALLBACK();
+	_count_read_call_internal();
+	int error_code = _write_packets_internal();
+	if (XHPTDC8_OK != error_code)
+	{
+		return error_code;
+	}
+
+	if (mngr.packet_read_words == mngr.packet_write_words)
+	{
+		*first_packet = NULL;
+		*last_packet = NULL;
+		return XHPTDC8_INSUFFICIENT_DATA;
+	}
+	*first_packet = (volatile crono_packet*)(mngr.packet_buffer + mngr.packet_read_words);
+	*last_packet = (volatile crono_packet*)(mngr.packet_buffer + mngr.packet_last_words);
+
+	return XHPTDC8_OK;
+}
+
+/*
+* Releases the packets up to and including packet.
+*/
+extern "C" int xhptdc8_acknowledge_packets(volatile crono_packet* packet)
+{
+	if (nullptr == packet || NULL == mngr.packet_buffer)
+	{
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+
+	uintptr_t packet_address = (uintptr_t)packet;
+	uintptr_t first_address = (uintptr_t)(mngr.packet_buffer + mngr.packet_read_words);
+	uintptr_t last_address = (uintptr_t)(mngr.packet_buffer + mngr.packet_last_words);
+	if (packet_address < first_address || packet_address > last_address ||
+		0 != (packet_address - first_address) % sizeof(uint64_t) ||
+		mngr.packet_read_words == mngr.packet_write_words)
+	{
+		_set_last_error_internal(ERR_MSG_INVALID_PACKET);
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+
+	// The packet must start at a packet boundary, otherwise the read position would point into a packet
+	size_t packet_words = (size_t)(packet_address - (uintptr_t)mngr.packet_buffer) / sizeof(uint64_t);
+	size_t words = mngr.packet_read_words;
+	while (words < packet_words)
+	{
+		words += crono_packet_bytes((crono_packet*)(mngr.packet_buffer + words)) / sizeof(uint64_t);
+	}
+	if (words != packet_words)
+	{
+		_set_last_error_internal(ERR_MSG_INVALID_PACKET);
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+
+	mngr.packet_read_words = packet_words + crono_packet_bytes(packet) / sizeof(uint64_t);
+
+	return XHPTDC8_OK;
+}
+
+/*
+* Registers the callback called by the callback thread while capturing.
+*/
+extern "C" int xhptdc8_register_hit_callback(xhptdc8_hit_callback callback, void* user_ctx, size_t batch_hint)
+{
+	if (ManagerState::UNINITIALIZED == mngr.state)
+	{
+		_set_last_error_internal(ERR_MSG_DEVICE_NOT_INIT);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	if (ManagerState::CAPTURING == mngr.state || ManagerState::PAUSED == mngr.state)
+	{
+		_set_last_error_internal(ERR_MSG_DEVICE_IS_CAPTURING);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	if (NULL != callback && (0 == batch_hint || batch_hint > mngr.host_buffer_hits))
+	{
+		_set_last_error_internal(ERR_MSG_INVALID_BUFFER_SIZE);
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+
+	delete[] g_callback_ring;
+	g_callback_ring = NULL;
+	g_callback_ring_hits = 0;
+	g_callback = NULL;
+	_publish_status_internal();
+	if (NULL == callback)
+	{
+		return XHPTDC8_OK;
+	}
+
+	size_t ring_hits = 1;
+	while (ring_hits < 64 * batch_hint)
+	{
+		ring_hits <<= 1;
+	}
+	try {
+		g_callback_ring = new TDCHit[ring_hits];
+	}
+	catch (std::bad_alloc& ba) {
+		fprintf(stdout, "Exception in memory allocation: %s", ba.what());
+		_set_last_error_internal(ERR_MSG_MEMORY_ALLOC);
+		return XHPTDC8_BUFFER_ALLOC_FAILED;
+	}
+	g_callback_ring_hits = ring_hits;
+	g_callback = callback;
+	g_callback_user_ctx = user_ctx;
+	g_callback_batch_hits = batch_hint;
+	_publish_status_internal();
+
+	return XHPTDC8_OK;
+}
+
+/*
+* Sets the CPUs of the callback threads, applied when the threads are started.
+*/
+extern "C" int xhptdc8_set_callback_affinity(uint64_t reader_cpu_mask, uint64_t callback_cpu_mask)
+{
+	if (!_is_valid_cpu_mask_internal(reader_cpu_mask) || !_is_valid_cpu_mask_internal(callback_cpu_mask))
+	{
+		_set_last_error_internal(ERR_MSG_INVALID_CPU_MASK);
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+	g_reader_cpu_mask = reader_cpu_mask;
+	g_callback_cpu_mask = callback_cpu_mask;
+
+	return XHPTDC8_OK;
+}
+
+/*
+* Reads the counters without a lock, see dummy_readout_stats.
+*/
+extern "C" int xhptdc8_get_readout_stats(int index, xhptdc8_readout_stats* stats)
+{
+	CHECK_VALID_DEVICE(index);
+
+	if (nullptr == stats)
+	{
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+
+	stats->size = sizeof(xhptdc8_readout_stats);
+	stats->version = XHPTDC8_READOUT_STATS_VERSION;
+	stats->written_hits = g_readout_stats.written_hits.load(std::memory_order_relaxed);
+	stats->delivered_hits = g_readout_stats.delivered_hits.load(std::memory_order_relaxed);
+	stats->lost_hits_host_buffer_full = g_readout_stats.lost_hits_host_buffer_full.load(std::memory_order_relaxed);
+	// The emulated board neither overflows its DMA FIFO nor loses packets
+	stats->lost_hits_dma_fifo_full = 0;
+	stats->lost_packets = 0;
+	stats->lost_hits_callback_ring = g_readout_stats.lost_hits_callback_ring.load(std::memory_order_relaxed);
+	stats->read_calls = g_readout_stats.read_calls.load(std::memory_order_relaxed);
+	stats->host_buffer_hits = g_readout_stats.host_buffer_hits.load(std::memory_order_relaxed);
+	stats->host_buffer_fill = g_readout_stats.host_buffer_fill.load(std::memory_order_relaxed);
+	stats->host_buffer_max_fill = g_readout_stats.host_buffer_max_fill.load(std::memory_order_relaxed);
+
+	return XHPTDC8_OK;
+}
+
+/*
+* Counts a call of a read function for xhptdc8_get_readout_stats().
+*/
+void _count_read_call_internal()
+{
+	mngr.read_hits_count++;
+	_add_readout_stat_internal(g_readout_stats.read_calls, 1);
+}
+
+extern "C" int xhptdc8_get_callback_stats(xhptdc8_callback_stats* stats)
+{
+	if (nullptr == stats)
+	{
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+
+	stats->delivered_hits = g_callback_read_count;
+	stats->dropped_hits = g_callback_dropped_hits;
+	stats->callback_calls = g_callback_calls;
+	dummy_status status;
+	_read_status_internal(&status);
+	stats->ring_size = status.callback_ring_hits;
+	stats->max_ring_fill = g_callback_max_fill;
+
+	return XHPTDC8_OK;
+}
+
+/*
+* xhptdc8_read_hits and xhptdc8_read_groups when groups are enabled
+* Copies complete groups found in the host buffer as long as they fit in hit_buf.
+* The first group is truncated if it is larger than hit_buf.
+* Returns the number of groups.
+*/
+int _read_hits_for_groups_internal(TDCHit* hit_buf, size_t size, xhptdc8_group_desc* groups, xhptdc8_group_header* headers, size_t max_groups)
+{
+	_fill_host_buffer_internal();
+
+	size_t group_count = 0;
+	size_t hit_count = 0;
+	dummy_group group;
+	while (group_count < max_groups && hit_count < size && _find_group_internal(&group))
+	{
+		size_t length = (size_t)(group.last - group.first);
+		if (length > size - hit_count)
+		{
+			if (group_count > 0)
+			{
+				// Left for the next call
+				break;
+			}
+			// The remaining hits of the group are discarded
+			length = size;
+		}
+		_copy_group_internal(&group, hit_buf + hit_count, length);
+		if (NULL != headers)
+		{
+			_fill_group_header_internal(&group, length, &headers[group_count]);
+			headers[group_count].offset = hit_count;
+		}
+		_consume_group_internal(&group, true);
+
+		if (NULL != groups)
+		{
+			groups[group_count].offset = hit_count;
+			groups[group_count].length = length;
+			groups[group_count].trigger_timestamp = group.trigger_time;
+		}
+		hit_count += length;
+		group_count++;
+	}
+	return int(group_count);
+}
+
+/*
+* Read as many complete groups as fit in the buffers provided by the user.
+*/
+extern "C" int xhptdc8_read_groups(TDCHit* hit_buf, size_t buf_len, xhptdc8_group_desc* groups, size_t max_groups)
+{
+	if (nullptr == hit_buf || nullptr == groups)
+	{
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+
+	if (mngr.state != ManagerState::CAPTURING)
+	{
+		_set_last_error_internal(ERR_MSG_DEVICE_IS_NOT_CAPURING);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	if (!mngr.p_mgr_cfg.grouping.enabled)
+	{
+		_set_last_error_internal(ERR_MSG_GROUPING_DISABLED);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	CHECK_NO_HIT_CALLBACK();
+	_count_read_call_internal();
+
+	return _read_hits_for_groups_internal(hit_buf, buf_len, groups, NULL, max_groups);
+}
+
+/*
+* Reads the next group into a matrix of timestamps per channel.
+*/
+extern "C" int xhptdc8_read_group_matrix(int64_t* absolute_trigger_timestamp, int32_t* hit_counter, int64_t* tdc_array,
+	int32_t* adc_counter, int32_t* adc_value, int32_t number_of_tdcs, int32_t number_of_channels, int32_t number_of_hits)
+{
+	if (nullptr == absolute_trigger_timestamp || nullptr == hit_counter || nullptr == tdc_array ||
+		nullptr == adc_counter || nullptr == adc_value || number_of_tdcs <= 0 || number_of_hits <= 0 ||
+		number_of_channels != number_of_tdcs * XHPTDC8_NOF_CHANNELS_PER_CARD)
+	{
+		_set_last_error_internal(ERR_MSG_INVALID_ARGS);
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+
+	if (mngr.state != ManagerState::CAPTURING)
+	{
+		_set_last_error_internal(ERR_MSG_DEVICE_IS_NOT_CAPURING);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	if (!mngr.p_mgr_cfg.grouping.enabled)
+	{
+		_set_last_error_internal(ERR_MSG_GROUPING_DISABLED);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	CHECK_NO_HIT_CALLBACK();
+	_count_read_call_internal();
+
+	memset(hit_counter, 0, number_of_channels * sizeof(int32_t));
+	memset(adc_counter, 0, number_of_tdcs * sizeof(int32_t));
+	*absolute_trigger_timestamp = 0;
+
+	_fill_host_buffer_internal();
+	dummy_group group;
+	if (!_find_group_internal(&group))
+	{
+		return 0;
+	}
+	*absolute_trigger_timestamp = group.trigger_time;
+	int hit_count = _fill_group_matrix_internal(&group, hit_counter, tdc_array, adc_counter, adc_value,
+		number_of_tdcs, number_of_hits);
+	_consume_group_internal(&group, true);
+
+	return hit_count;
+}
+
+/*
+* xhptdc8_read_groups with a header for every group.
+*/
+extern "C" int xhptdc8_read_group_headers(TDCHit* hit_buf, size_t buf_len, xhptdc8_group_header* headers, size_t max_groups)
+{
+	if (nullptr == hit_buf || nullptr == headers)
+	{
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+
+	if (mngr.state != ManagerState::CAPTURING)
+	{
+		_set_last_error_internal(ERR_MSG_DEVICE_IS_NOT_CAPURING);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	if (!mngr.p_mgr_cfg.grouping.enabled)
+	{
+		_set_last_error_internal(ERR_MSG_GROUPING_DISABLED);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	CHECK_NO_HIT_CALLBACK();
+	_count_read_call_internal();
+
+	return _read_hits_for_groups_internal(hit_buf, buf_len, NULL, headers, max_groups);
+}
+
+/*
+* Size of the next group, or of its unread part.
+*/
+extern "C" int xhptdc8_peek_group_size(size_t* hits)
+{
+	if (nullptr == hits)
+	{
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+
+	if (mngr.state != ManagerState::CAPTURING)
+	{
+		_set_last_error_internal(ERR_MSG_DEVICE_IS_NOT_CAPURING);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	if (!mngr.p_mgr_cfg.grouping.enabled)
+	{
+		_set_last_error_internal(ERR_MSG_GROUPING_DISABLED);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	CHECK_NO_HIT_CALLBACK();
+
+	*hits = 0;
+	_fill_host_buffer_internal();
+	dummy_group group;
+	if (!_find_group_internal(&group))
+	{
+		return XHPTDC8_INSUFFICIENT_DATA;
+	}
+	*hits = (size_t)(group.last - group.first);
+
+	return XHPTDC8_OK;
+}
+
+/*
+* Reads up to buf_len hits of the next group, the rest of the group is kept for the 
+* next call.
+*/
+extern "C" int xhptdc8_read_group_part(TDCHit* hit_buf, size_t buf_len, int64_t* trigger_timestamp, size_t* remaining)
+{
+	if (nullptr == hit_buf || nullptr == trigger_timestamp || nullptr == remaining)
+	{
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+
+	if (mngr.state != ManagerState::CAPTURING)
+	{
+		_set_last_error_internal(ERR_MSG_DEVICE_IS_NOT_CAPURING);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	if (!mngr.p_mgr_cfg.grouping.enabled)
+	{
+		_set_last_error_internal(ERR_MSG_GROUPING_DISABLED);
+		return XHPTDC8_WRONG_STATE;
+	}
+
+	CHECK_NO_HIT_CALLBACK();
+	_count_read_call_internal();
+
+	*remaining = 0;
+	_fill_host_buffer_internal();
+	dummy_group group;
+	if (!_find_group_internal(&group))
+	{
+		return 0;
+	}
+	*trigger_timestamp = group.trigger_time;
+	size_t length = (size_t)(group.last - group.first);
+	if (length > buf_len)
+	{
+		_copy_group_internal(&group, hit_buf, buf_len);
+		mngr.group_read_hits += buf_len;
+		*remaining = length - buf_len;
+		return int(buf_len);
+	}
+	_copy_group_internal(&group, hit_buf, length);
+	_consume_group_internal(&group, true);
+
+	return int(length);
+}
+
+int xhptdc8_read_user_flash(int index, uint8_t* flash_data, uint32_t size)
+{
+	CHECK_VALID_DEVICE(index);
+
+	if (nullptr == flash_data)
+		return XHPTDC8_INVALID_ARGUMENTS;
+
+	if (size <= 0 )
+		return XHPTDC8_INVALID_ARGUMENTS;
+
+	if (NULL != mngr.user_flash) {
+		memcpy(flash_data, mngr.user_flash,
+			mngr.user_flash_size > size ? size : mngr.user_flash_size);
+		if (mngr.user_flash_size < size)
+			size = mngr.user_flash_size;
+	}
+
+	return XHPTDC8_OK;
+}
+
+int xhptdc8_write_user_flash(int index, uint8_t* flash_data, uint32_t size)
+{
+	CHECK_VALID_DEVICE(index);
+
+	if (nullptr == flash_data)
+		return XHPTDC8_INVALID_ARGUMENTS;
+
+	if (size <= 0)
+		return XHPTDC8_INVALID_ARGUMENTS;
+
+	if (NULL != mngr.user_flash) {
+		delete mngr.user_flash;
+		mngr.user_flash = NULL;
+	}
+	try {
+		mngr.user_flash = new unsigned char[size];
+	}
+	catch (std::bad_alloc& ba) {
+		fprintf(stdout, "Exception in memory allocation: %s", ba.what());
+		_set_last_error_internal(ERR_MSG_MEMORY_ALLOC);
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+	memcpy(mngr.user_flash, flash_data, size);
+	mngr.user_flash_size = size;
+
+	return XHPTDC8_OK;
+}
+
+extern "C" int xhptdc8_software_trigger(int index) 
+{
+	CHECK_VALID_DEVICE(index);
+	if ((mngr.dev_state != DeviceState::CREATED) || (mngr.dev_state != DeviceState::CLOSED))
+	{
+		_set_last_error_internal(ERR_MSG_DEVICE_NOT_READY_TRIG);
+		return XHPTDC8_WRONG_STATE;
+	}
+	return XHPTDC8_OK;
+}
+
+/*
+* Returns the board time in picoseconds, the emulated DMA engine writes the hits of 
+* board time t at host time g_timestamp_base_time + t.
+*/
+extern "C" int xhptdc8_get_current_timestamp(int index, int64_t* timestamp)
+{
+	CHECK_VALID_DEVICE(index);
+	if (nullptr == timestamp)
+	{
+		return XHPTDC8_INVALID_ARGUMENTS;
+	}
+	int64_t base_time = g_timestamp_base_time;
+	if (base_time < 0)
+	{
+		_set_last_error_internal(ERR_MSG_DEVICE_NOT_INIT);
+		return XHPTDC8_WRONG_STATE;
+	}
+	*timestamp = (_get_time_ns_internal() - base_time) * 1000;
+
+	return XHPTDC8_OK;
+}
 
 //_____________________________________________________________________________
 // Internal Functions
 
-void _set_last_error_printf_internal(const char* format, ...)
+/*
+* Configures a board in its own thread, so the boards are aligned in parallel. The 
+* last board signals the waiting control thread and the eventfd of the handle.
+*
+* Specific to Dummy Library:
+* - Waits DUMMY_ALIGNMENT_MS unless skip_alignment is set instead of aligning the TDCs
+*/
+void _configure_board_internal(xhptdc8_configure_handle* handle, int device_index)
+{
+	if (!handle->config.device_configs[device_index].skip_alignment)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(DUMMY_ALIGNMENT_MS));
+	}
+	handle->board_results[device_index] = XHPTDC8_OK;
+
+	if (1 == handle->pending_boards.fetch_sub(1, std::memory_order_acq_rel))
+	{
+		std::lock_guard<std::mutex> lock(handle->mutex);
+		handle->finished = true;
+#ifdef __linux__
+		if (handle->event_fd >= 0)
+		{
+			uint64_t increment = 1;
+			if (write(handle->event_fd, &increment, sizeof(increment)) < 0)
+			{
+				// Counter can't overflow, it is written once
+			}
+		}
+#endif
+		handle->finished_cv.notify_all();
+	}
+}
+
+/*
+* Applies a finished configuration to the manager, called by the control thread.
+* Returns the result of the first board that failed, or XHPTDC8_OK.
+*/
+int _apply_configure_internal(xhptdc8_configure_handle* handle)
+{
+	if (handle->applied)
+	{
+		return handle->result;
+	}
+	for (int device_index = 0; device_index < DUMMY_DEVICES_COUNT; device_index++)
+	{
+		handle->board_threads[device_index].join();
+		if (XHPTDC8_OK == handle->result)
+		{
+			handle->result = handle->board_results[device_index];
+		}
+	}
+	if (XHPTDC8_OK == handle->result)
+	{
+		memcpy(&(mngr.p_mgr_cfg), &(handle->config), sizeof(xhptdc8_manager_configuration));
+		mngr.state = ManagerState::CONFIGURED;
+		mngr.dev_state = DeviceState::CONFIGURED;
+		_publish_status_internal();
+	}
+	else
+	{
+		mngr.state = handle->previous_state;
+	}
+	g_configure = NULL;
+	handle->applied = true;
+	return handle->result;
+}
+
+/*
+* Publishes the status of mngr for the info functions, called by the control thread
+* after each change.
+*/
+void _publish_status_internal()
+{
+	dummy_status status;
+	memset(&status, 0, sizeof(dummy_status));
+	status.dev_state = mngr.dev_state;
+	status.static_info = mngr.staticInfo;
+	status.total_buffer = (int64_t)(mngr.host_buffer_hits * sizeof(TDCHit));
+	status.numa_node = _get_host_buffer_numa_node_internal();
+	status.cpu_mask = mngr.params.cpu_mask[0];
+	status.callback_ring_hits = g_callback_ring_hits;
+	uint64_t words[DUMMY_STATUS_WORDS] = { 0 };
+	memcpy(words, &status, sizeof(dummy_status));
+
+	std::lock_guard<std::mutex> lock(g_status_write_mutex);
+	uint32_t sequence = g_status_sequence.load(std::memory_order_relaxed);
+	g_status_sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	for (size_t word = 0; word < DUMMY_STATUS_WORDS; word++)
+	{
+		g_status_words[word].store(words[word], std::memory_order_relaxed);
+	}
+	g_status_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+/*
+* Copies the published status, retries while _publish_status_internal() writes it. 
+* All zero before the first *_init(), i.e. dev_state is CREATED.
+*/
+void _read_status_internal(dummy_status* status)
+{
+	uint64_t words[DUMMY_STATUS_WORDS];
+	uint32_t sequence;
+	do
+	{
+		sequence = g_status_sequence.load(std::memory_order_acquire);
+		for (size_t word = 0; word < DUMMY_STATUS_WORDS; word++)
+		{
+			words[word] = g_status_words[word].load(std::memory_order_relaxed);
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+	} while ((sequence & 1) || sequence != g_status_sequence.load(std::memory_order_relaxed));
+	memcpy(status, words, sizeof(dummy_status));
+}
+
+/*
+* Allocates the host buffer of params.buffer_size bytes, or of 
+* DUMMY_DEFAULT_BUFFER_SIZE bytes if buffer_size is 0.
+*/
+int _alloc_host_buffer_internal()
+{
+	int64_t buffer_size = (0 == mngr.params.buffer_size) ? DUMMY_DEFAULT_BUFFER_SIZE : mngr.params.buffer_size;
+	if (buffer_size < (int64_t)(2 * sizeof(TDCHit)))
+	{
+		_set_last_error_internal(ERR_MSG_INVALID_BUFFER_SIZE);
+		return XHPTDC8_INVALID_BUFFER_PARAMETERS;
+	}
+
+	_free_host_buffer_internal();
+	if (XHPTDC8_BUFFER_PAGES_DEFAULT == mngr.params.buffer_pages && !mngr.params.lock_buffer &&
+		mngr.params.numa_node[0] < 0)
+	{
+		mngr.host_buffer_hits = (size_t)(buffer_size / sizeof(TDCHit));
+		try {
+			mngr.host_buffer = new TDCHit[mngr.host_buffer_hits];
+		}
+		catch (std::bad_alloc& ba) {
+			fprintf(stdout, "Exception in memory allocation: %s", ba.what());
+			mngr.host_buffer_hits = 0;
+			_set_last_error_internal(ERR_MSG_MEMORY_ALLOC);
+			return XHPTDC8_BUFFER_ALLOC_FAILED;
+		}
+	}
+	else
+	{
+		size_t bytes = (size_t)buffer_size;
+		void* buffer = _alloc_pages_internal(&bytes);
+		if (NULL == buffer)
+		{
+			return XHPTDC8_BUFFER_ALLOC_FAILED;
+		}
+		mngr.host_buffer = (TDCHit*)buffer;
+		mngr.host_buffer_mapped_bytes = bytes;
+		mngr.host_buffer_hits = bytes / sizeof(TDCHit);
+	}
+	_reset_host_buffer_internal();
+
+	return XHPTDC8_OK;
+}
+
+void _free_host_buffer_internal()
+{
+	if (NULL != mngr.host_buffer) {
+		if (0 != mngr.host_buffer_mapped_bytes) {
+			_free_pages_internal(mngr.host_buffer, mngr.host_buffer_mapped_bytes);
+		}
+		else {
+			delete[] mngr.host_buffer;
+		}
+		mngr.host_buffer = NULL;
+	}
+	mngr.host_buffer_hits = 0;
+	mngr.host_buffer_mapped_bytes = 0;
+	if (NULL != mngr.packet_buffer) {
+		delete[] mngr.packet_buffer;
+		mngr.packet_buffer = NULL;
+	}
+	mngr.packet_buffer_words = 0;
+}
+
+/*
+* Allocates *bytes rounded up to the page size of params.buffer_pages on NUMA node 
+* params.numa_node, and locks the pages if params.lock_buffer is set. *bytes is set 
+* to the allocated size.
+*/
+void* _alloc_pages_internal(size_t* bytes)
+{
+	size_t page_size;
+	switch (mngr.params.buffer_pages)
+	{
+	case XHPTDC8_BUFFER_PAGES_DEFAULT:
+		page_size = 4096;
+		break;
+	case XHPTDC8_BUFFER_PAGES_2MB:
+		page_size = 2 * 1024 * 1024;
+		break;
+	case XHPTDC8_BUFFER_PAGES_1GB:
+		page_size = 1024 * 1024 * 1024;
+		break;
+	default:
+		_set_last_error_internal(ERR_MSG_BUFFER_PAGES_NOT_SUPPORTED);
+		return NULL;
+	}
+	*bytes = (*bytes + page_size - 1) / page_size * page_size;
+
+#ifdef _WIN32
+	int numa_node = mngr.params.numa_node[0];
+	DWORD allocation_type = MEM_COMMIT | MEM_RESERVE;
+	if (XHPTDC8_BUFFER_PAGES_DEFAULT != mngr.params.buffer_pages)
+	{
+		// Large pages are always locked
+		if (XHPTDC8_BUFFER_PAGES_1GB == mngr.params.buffer_pages || GetLargePageMinimum() != page_size)
+		{
+			_set_last_error_internal(ERR_MSG_BUFFER_PAGES_NOT_SUPPORTED);
+			return NULL;
+		}
+		allocation_type |= MEM_LARGE_PAGES;
+	}
+	void* buffer = (numa_node >= 0) ?
+		VirtualAllocExNuma(GetCurrentProcess(), NULL, *bytes, allocation_type, PAGE_READWRITE, (DWORD)numa_node) :
+		VirtualAlloc(NULL, *bytes, allocation_type, PAGE_READWRITE);
+	if (NULL == buffer)
+	{
+		_set_last_error_system_internal(
+			(allocation_type & MEM_LARGE_PAGES) ? ERR_MSG_HUGE_PAGES_FAILED : ERR_MSG_MEMORY_ALLOC, GetLastError());
+		return NULL;
+	}
+	if (mngr.params.lock_buffer && !(allocation_type & MEM_LARGE_PAGES))
+	{
+		SIZE_T min_size, max_size;
+		GetProcessWorkingSetSize(GetCurrentProcess(), &min_size, &max_size);
+		SetProcessWorkingSetSize(GetCurrentProcess(), min_size + *bytes, max_size + *bytes);
+		if (!VirtualLock(buffer, *bytes))
+		{
+			_set_last_error_system_internal(ERR_MSG_LOCK_BUFFER_FAILED, GetLastError());
+			VirtualFree(buffer, 0, MEM_RELEASE);
+			return NULL;
+		}
+		mngr.host_buffer_locked = true;
+	}
+	return buffer;
+#elif defined(__linux__)
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+	if (XHPTDC8_BUFFER_PAGES_2MB == mngr.params.buffer_pages)
+	{
+		flags |= MAP_HUGETLB | (21 << MAP_HUGE_SHIFT);
+	}
+	else if (XHPTDC8_BUFFER_PAGES_1GB == mngr.params.buffer_pages)
+	{
+		flags |= MAP_HUGETLB | (30 << MAP_HUGE_SHIFT);
+	}
+	void* buffer = mmap(NULL, *bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+	if (MAP_FAILED == buffer)
+	{
+		_set_last_error_system_internal((flags & MAP_HUGETLB) ? ERR_MSG_HUGE_PAGES_FAILED : ERR_MSG_MEMORY_ALLOC, errno);
+		return NULL;
+	}
+	int numa_node = mngr.params.numa_node[0];
+	if (numa_node >= 0)
+	{
+		// Pages are allocated on the node when they are touched first, i.e. by mlock() or memset()
+		unsigned long node_mask[16] = { 0 };
+		const unsigned long node_bits = 8 * sizeof(unsigned long);
+		bool bound = false;
+		if (numa_node < (int)(16 * node_bits))
+		{
+			node_mask[numa_node / node_bits] = 1UL << (numa_node % node_bits);
+			bound = (0 == syscall(SYS_mbind, buffer, *bytes, MPOL_BIND, node_mask, 16 * node_bits, 0));
+		}
+		else
+		{
+			errno = EINVAL;
+		}
+		if (!bound)
+		{
+			_set_last_error_system_internal(ERR_MSG_NUMA_BIND_FAILED, errno);
+			munmap(buffer, *bytes);
+			return NULL;
+		}
+	}
+	if (mngr.params.lock_buffer && 0 != mlock(buffer, *bytes))
+	{
+		_set_last_error_system_internal(ERR_MSG_LOCK_BUFFER_FAILED, errno);
+		munmap(buffer, *bytes);
+		return NULL;
+	}
+	mngr.host_buffer_locked = mngr.params.lock_buffer;
+	if (numa_node >= 0 && !mngr.params.lock_buffer)
+	{
+		memset(buffer, 0, *bytes);
+	}
+	return buffer;
+#else
+	_set_last_error_internal(ERR_MSG_BUFFER_PAGES_NOT_SUPPORTED);
+	return NULL;
+#endif
+}
+
+/*
+* NUMA node of the first page of the host buffer, -1 if unknown.
+*/
+int _get_host_buffer_numa_node_internal()
+{
+	if (NULL == mngr.host_buffer)
+	{
+		return -1;
+	}
+#ifdef __linux__
+	int numa_node = -1;
+	if (0 != syscall(SYS_get_mempolicy, &numa_node, NULL, 0, (void*)mngr.host_buffer, MPOL_F_NODE | MPOL_F_ADDR))
+	{
+		return -1;
+	}
+	return numa_node;
+#else
+	return mngr.params.numa_node[0];
+#endif
+}
+
+void _free_pages_internal(void* buffer, size_t bytes)
+{
+#ifdef _WIN32
+	if (mngr.host_buffer_locked)
+	{
+		VirtualUnlock(buffer, bytes);
+	}
+	VirtualFree(buffer, 0, MEM_RELEASE);
+#elif defined(__linux__)
+	munmap(buffer, bytes);
+#endif
+	mngr.host_buffer_locked = false;
+}
+
+/*
+* Emulates the DMA engine writing packets, the available hits are moved from the 
+* host buffer to the packet buffer. A packet contains the hits of an interval of 
+* 2^32 ps that starts at the packet timestamp, up to DUMMY_PACKET_MAX_HITS hits.
+*/
+int _write_packets_internal()
+{
+	if (NULL == mngr.packet_buffer)
+	{
+		// Same size as the host buffer, each hit takes 8 bytes plus packet headers
+		mngr.packet_buffer_words = mngr.host_buffer_hits * sizeof(TDCHit) / 8;
+		try {
+			mngr.packet_buffer = new uint64_t[mngr.packet_buffer_words];
+		}
+		catch (std::bad_alloc& ba) {
+			fprintf(stdout, "Exception in memory allocation: %s", ba.what());
+			mngr.packet_buffer_words = 0;
+			_set_last_error_internal(ERR_MSG_MEMORY_ALLOC);
+			return XHPTDC8_BUFFER_ALLOC_FAILED;
+		}
+		mngr.packet_read_words = 0;
+		mngr.packet_write_words = 0;
+	}
+
+	// Move packets not yet acknowledged to the start of the buffer
+	if (mngr.packet_read_words > 0)
+	{
+		size_t pending_words = mngr.packet_write_words - mngr.packet_read_words;
+		memmove(mngr.packet_buffer, mngr.packet_buffer + mngr.packet_read_words, pending_words * sizeof(uint64_t));
+		mngr.packet_last_words -= (pending_words > 0) ? mngr.packet_read_words : mngr.packet_last_words;
+		mngr.packet_read_words = 0;
+		mngr.packet_write_words = pending_words;
+	}
+
+	_fill_host_buffer_internal();
+	mngr.acquired_hits = 0;
+
+	crono_packet* packet = NULL;
+	bool buffer_full = false;
+	while (!buffer_full)
+	{
+		const TDCHit* view;
+		size_t available_hits = _get_host_buffer_view_internal(&view);
+		if (0 == available_hits)
+		{
+			break;
+		}
+		size_t hit_index = 0;
+		for (; hit_index < available_hits; hit_index++)
+		{
+			const TDCHit* hit = &(view[hit_index]);
+			int64_t packet_time = hit->time & ~(int64_t)XHPTDC8_PACKED_MAX_DELTA;
+			if (NULL == packet || packet->timestamp != packet_time || DUMMY_PACKET_MAX_HITS == packet->length)
+			{
+				// Header of two words and the hit
+				if (mngr.packet_buffer_words - mngr.packet_write_words < 3)
+				{
+					buffer_full = true;
+					break;
+				}
+				packet = (crono_packet*)(mngr.packet_buffer + mngr.packet_write_words);
+				packet->channel = 0;
+				packet->card = 0;
+				packet->type = CRONO_PACKET_TYPE_TDC_DATA;
+				packet->flags = 0;
+				packet->length = 0;
+				packet->timestamp = packet_time;
+				mngr.packet_last_words = mngr.packet_write_words;
+				mngr.packet_write_words += 2;
+			}
+			else if (mngr.packet_buffer_words == mngr.packet_write_words)
+			{
+				buffer_full = true;
+				break;
+			}
+			if (hit->type & XHPTDC8_TDCHIT_TYPE_ERROR_HOST_BUFFER_FULL)
+			{
+				packet->flags |= CRONO_PACKET_FLAG_HOST_BUFFER_FULL;
+			}
+			packet->data[packet->length++] = XHPTDC8_PACKED_HIT(hit->channel, hit->type, hit->bin, hit->time - packet_time);
+			mngr.packet_write_words++;
+		}
+		_advance_read_position_internal(hit_index);
+	}
+
+	return XHPTDC8_OK;
+}
+
+void _free_demux_queues_internal()
+{
+	for (int channel = 0; channel < DUMMY_DEMUX_QUEUE_COUNT; channel++)
+	{
+		delete[] g_demux_queues[channel].hits;
+		g_demux_queues[channel].hits = NULL;
+	}
+	g_demux_queue_hits = 0;
+}
+
+/*
+* Empties the host buffer and restarts the emulated DMA engine.
+*/
+void _reset_host_buffer_internal()
+{
+	mngr.dma_write_count = 0;
+	mngr.dma_read_count = 0;
+	g_event_read_count = 0;
+	g_readout_stats.host_buffer_fill.store(0, std::memory_order_relaxed);
+	mngr.acquired_hits = 0;
+	mngr.dma_fill_time = _get_time_ns_internal() - _get_dma_read_delay_ns_internal();
+	mngr.dma_emulated_ms = 0;
+	g_timestamp_base_time = mngr.dma_fill_time + _get_dma_read_delay_ns_internal();
+	mngr.host_buffer_full = false;
+	mngr.group_scan_count = 0;
+	mngr.group_has_trigger = false;
+	mngr.group_read_hits = 0;
+	mngr.group_sequence = 0;
+	mngr.packet_read_words = 0;
+	mngr.packet_write_words = 0;
+	mngr.packet_last_words = 0;
+}
+
+/*
+* Emulates the DMA engine, writes one start and one stop hit for every millisecond
+* elapsed since the last call to the host buffer.
+* Hits that do not fit in the host buffer are discarded, the next written hit is
+* flagged with XHPTDC8_TDCHIT_TYPE_ERROR_HOST_BUFFER_FULL.
+*/
+void _fill_host_buffer_internal()
+{
+	// The write pointer is updated dma_read_delay after the hits have been written
+	int64_t elapsed_ms = (_get_time_ns_internal() - _get_dma_read_delay_ns_internal() - mngr.dma_fill_time) / 1000000;
+	if (elapsed_ms <= 0)
+	{
+		return;
+	}
+	mngr.dma_fill_time += elapsed_ms * 1000000;
+	// Raw TDC bins of 1000 / 76.8 ps, see xhptdc8_param_info::binsize
+	const bool raw_bins = XHPTDC8_TIME_UNIT_BINS == mngr.p_mgr_cfg.time_unit;
+
+	for (int64_t ms_index = 0; ms_index < elapsed_ms; ms_index++, mngr.dma_emulated_ms++)
+	{
+		if (mngr.host_buffer_hits - (size_t)(mngr.dma_write_count - mngr.dma_read_count) < 2)
+		{
+			mngr.host_buffer_full = true;
+			_add_readout_stat_internal(g_readout_stats.lost_hits_host_buffer_full, 2);
+			continue;
+		}
+		int normal = int(g_distribution(g_generator));
+		for (int hit_index = 0; hit_index < 2; hit_index++)
+		{
+			TDCHit* hit = &(mngr.host_buffer[mngr.dma_write_count % mngr.host_buffer_hits]);
+			hit->time = mngr.dma_emulated_ms * 1000000000 + (hit_index ? normal : 0);
+			if (raw_bins)
+			{
+				// Bins of 1250/96 ps, divided first as time * 96 overflows after 26 hours
+				hit->time = hit->time / 1250 * 96 + hit->time % 1250 * 96 / 1250;
+			}
+			hit->channel = (uint8_t)hit_index;
+			hit->type = XHPTDC8_TDCHIT_TYPE_RISING;
+			if (mngr.host_buffer_full)
+			{
+				hit->type |= XHPTDC8_TDCHIT_TYPE_ERROR | XHPTDC8_TDCHIT_TYPE_ERROR_HOST_BUFFER_FULL;
+				mngr.host_buffer_full = false;
+			}
+			hit->bin = 0;
+			hit->reserved = 0;
+			mngr.dma_write_count++;
+		}
+		_add_readout_stat_internal(g_readout_stats.written_hits, 2);
+	}
+	uint64_t fill = mngr.dma_write_count - mngr.dma_read_count;
+	g_readout_stats.host_buffer_fill.store(fill, std::memory_order_relaxed);
+	if (fill > g_readout_stats.host_buffer_max_fill.load(std::memory_order_relaxed))
+	{
+		g_readout_stats.host_buffer_max_fill.store(fill, std::memory_order_relaxed);
+	}
+}
+
+bool _has_hit_callback_internal()
+{
+	return NULL != g_callback;
+}
+
+/*
+* Restricts thread to the CPUs set in cpu_mask, no restriction if cpu_mask is 0.
+*/
+int _set_thread_affinity_internal(std::thread& thread, uint64_t cpu_mask)
+{
+	if (0 == cpu_mask)
+	{
+		return XHPTDC8_OK;
+	}
+#ifdef _WIN32
+	if (0 == SetThreadAffinityMask(thread.native_handle(), (DWORD_PTR)cpu_mask))
+	{
+		_set_last_error_system_internal(ERR_MSG_SET_AFFINITY_FAILED, GetLastError());
+		return XHPTDC8_INTERNAL_ERROR;
+	}
+#elif defined(__linux__)
+	cpu_set_t cpu_set;
+	CPU_ZERO(&cpu_set);
+	for (int cpu = 0; cpu < 64; cpu++)
+	{
+		if ((cpu_mask >> cpu) & 1)
+		{
+			CPU_SET(cpu, &cpu_set);
+		}
+	}
+	int error_number = pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set), &cpu_set);
+	if (0 != error_number)
+	{
+		_set_last_error_system_internal(ERR_MSG_SET_AFFINITY_FAILED, error_number);
+		return XHPTDC8_INTERNAL_ERROR;
+	}
+#endif
+	return XHPTDC8_OK;
+}
+
+/*
+* Checks that cpu_mask contains at least one CPU of the system, 0 allows all CPUs.
+*/
+bool _is_valid_cpu_mask_internal(uint64_t cpu_mask)
+{
+	unsigned cpu_count = std::thread::hardware_concurrency();
+	if (0 == cpu_mask || 0 == cpu_count || cpu_count >= 64)
+	{
+		return true;
+	}
+	return 0 != (cpu_mask & ((1ULL << cpu_count) - 1));
+}
+
+int _start_callback_threads_internal()
+{
+	if (!_has_hit_callback_internal() || g_reader_thread.joinable())
+	{
+		return XHPTDC8_OK;
+	}
+	g_reader_thread_stop = false;
+	g_callback_thread_stop = false;
+	try {
+		g_reader_thread = std::thread(_callback_reader_thread_internal);
+		g_callback_thread = std::thread(_callback_thread_internal);
+	}
+	catch (std::system_error&) {
+		// Stops the reader thread, if it has been started
+		_stop_callback_threads_internal();
+		_set_last_error_internal(ERR_MSG_THREAD_START_FAILED);
+		return XHPTDC8_INTERNAL_ERROR;
+	}
+	// A thread that cannot be pinned is not left running on other CPUs
+	int error_code = _set_thread_affinity_internal(g_reader_thread,
+		(0 != g_reader_cpu_mask) ? g_reader_cpu_mask : mngr.params.cpu_mask[0]);
+	if (XHPTDC8_OK == error_code)
+	{
+		error_code = _set_thread_affinity_internal(g_callback_thread,
+			(0 != g_callback_cpu_mask) ? g_callback_cpu_mask : mngr.params.cpu_mask[0]);
+	}
+	if (XHPTDC8_OK != error_code)
+	{
+		_stop_callback_threads_internal();
+	}
+	return error_code;
+}
+
+/*
+* Stops the reader thread, then the callback thread once it has delivered the hits
+* of the ring.
+*/
+void _stop_callback_threads_internal()
+{
+	if (!g_reader_thread.joinable())
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(g_callback_mutex);
+		g_reader_thread_stop = true;
+	}
+	g_reader_cv.notify_one();
+	g_reader_thread.join();
+	if (!g_callback_thread.joinable())
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(g_callback_mutex);
+		g_callback_thread_stop = true;
+	}
+	g_callback_cv.notify_one();
+	g_callback_thread.join();
+}
+
+/*
+* Moves the hits written by the emulated DMA engine to the callback ring. Hits that
+* do not fit in the ring are dropped.
+*/
+void _callback_reader_thread_internal()
+{
+	size_t ring_mask = g_callback_ring_hits - 1;
+	std::unique_lock<std::mutex> lock(g_callback_mutex);
+	while (!g_reader_thread_stop)
+	{
+		lock.unlock();
+		_fill_host_buffer_internal();
+		uint64_t write_count = g_callback_write_count.load(std::memory_order_relaxed);
+		uint64_t read_count = g_callback_read_count.load(std::memory_order_acquire);
+		while (true)
+		{
+			const TDCHit* view;
+			size_t available_hits = _get_host_buffer_view_internal(&view);
+			if (0 == available_hits)
+			{
+				break;
+			}
+			size_t free_hits = g_callback_ring_hits - (size_t)(write_count - read_count);
+			size_t copy_hits = (available_hits < free_hits) ? available_hits : free_hits;
+			for (size_t hit_index = 0; hit_index < copy_hits; hit_index++)
+			{
+				g_callback_ring[(write_count + hit_index) & ring_mask] = view[hit_index];
+			}
+			write_count += copy_hits;
+			g_callback_dropped_hits += available_hits - copy_hits;
+			_add_readout_stat_internal(g_readout_stats.lost_hits_callback_ring, available_hits - copy_hits);
+			_advance_read_position_internal(available_hits);
+		}
+		g_callback_write_count.store(write_count, std::memory_order_release);
+		if (write_count - read_count > g_callback_max_fill)
+		{
+			g_callback_max_fill = write_count - read_count;
+		}
+
+		lock.lock();
+		if (write_count - read_count >= g_callback_batch_hits)
+		{
+			g_callback_cv.notify_one();
+		}
+		// Sleep until the DMA engine writes the next hits
+		int64_t wake_up = mngr.dma_fill_time + 1000000 + _get_dma_read_delay_ns_internal();
+		g_reader_cv.wait_until(lock, std::chrono::steady_clock::time_point(
+			std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(wake_up))));
+	}
+}
+
+/*
+* Calls the callback with the hits of the callback ring, directly from the ring.
+*/
+void _callback_thread_internal()
+{
+	size_t ring_mask = g_callback_ring_hits - 1;
+	std::unique_lock<std::mutex> lock(g_callback_mutex);
+	while (true)
+	{
+		// Wait for a full batch, deliver partial batches after 1 ms
+		g_callback_cv.wait_for(lock, std::chrono::milliseconds(1), [] {
+			return g_callback_thread_stop || 
+				(g_callback_write_count.load() - g_callback_read_count.load() >= g_callback_batch_hits);
+		});
+		bool stop = g_callback_thread_stop;
+		lock.unlock();
+
+		uint64_t read_count = g_callback_read_count.load(std::memory_order_relaxed);
+		uint64_t available_hits = g_callback_write_count.load(std::memory_order_acquire) - read_count;
+		while (available_hits > 0)
+		{
+			size_t read_index = (size_t)(read_count & ring_mask);
+			size_t batch_hits = g_callback_ring_hits - read_index;
+			if (batch_hits > available_hits)
+			{
+				batch_hits = (size_t)available_hits;
+			}
+			if (batch_hits > g_callback_batch_hits)
+			{
+				batch_hits = g_callback_batch_hits;
+			}
+			g_callback(g_callback_user_ctx, g_callback_ring + read_index, batch_hits);
+			g_callback_calls++;
+			read_count += batch_hits;
+			available_hits -= batch_hits;
+			g_callback_read_count.store(read_count, std::memory_order_release);
+			if (!stop && available_hits < g_callback_batch_hits)
+			{
+				// Wait for the batch to fill up
+				break;
+			}
+		}
+
+		if (stop)
+		{
+			// The reader thread has already stopped, all hits have been delivered
+			return;
+		}
+		lock.lock();
+	}
+}
+
+/*
+* Marks hits as read by the user, they can be overwritten by the DMA engine.
+*/
+void _advance_read_position_internal(size_t hits)
+{
+	mngr.dma_read_count += hits;
+	g_event_read_count.store(mngr.dma_read_count, std::memory_order_release);
+	_add_readout_stat_internal(g_readout_stats.delivered_hits, hits);
+	g_readout_stats.host_buffer_fill.store(mngr.dma_write_count - mngr.dma_read_count, std::memory_order_relaxed);
+	if (g_event_thread.joinable())
+	{
+		// The user has read the signaled hits, let the event thread check the
+		// watermark again
+		std::lock_guard<std::mutex> lock(g_event_mutex);
+		g_event_signaled = false;
+		g_event_cv.notify_one();
+	}
+}
+
+/*
+* Starts the thread signaling g_event_fd, if the user has requested the eventfd.
+* The emulated DMA engine is driven by the reading thread, so the event thread 
+* calculates the written hits from the time elapsed since it was started.
+*/
+int _start_event_thread_internal()
+{
+	if (g_event_fd < 0 || g_event_thread.joinable())
+	{
+		return XHPTDC8_OK;
+	}
+	g_event_base_write_count = mngr.dma_write_count;
+	g_event_base_fill_time = mngr.dma_fill_time;
+	g_event_dma_read_delay = _get_dma_read_delay_ns_internal();
+	g_event_buffer_hits = mngr.host_buffer_hits;
+	g_event_thread_stop = false;
+	g_event_signaled = false;
+#ifdef __linux__
+	// Discard events of a previous capture
+	uint64_t counter;
+	while (read(g_event_fd, &counter, sizeof(counter)) > 0)
+		;
+#endif
+	try {
+		g_event_thread = std::thread(_event_thread_internal);
+	}
+	catch (std::system_error&) {
+		_set_last_error_internal(ERR_MSG_THREAD_START_FAILED);
+		return XHPTDC8_INTERNAL_ERROR;
+	}
+	int error_code = _set_thread_affinity_internal(g_event_thread, mngr.params.cpu_mask[0]);
+	if (XHPTDC8_OK != error_code)
+	{
+		_stop_event_thread_internal();
+	}
+	return error_code;
+}
+
+void _stop_event_thread_internal()
+{
+	if (!g_event_thread.joinable())
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(g_event_mutex);
+		g_event_thread_stop = true;
+	}
+	g_event_cv.notify_one();
+	g_event_thread.join();
+}
+
+void _close_event_fd_internal()
+{
+	_stop_event_thread_internal();
+#ifdef __linux__
+	if (g_event_fd >= 0)
+	{
+		close(g_event_fd);
+	}
+#endif
+	g_event_fd = -1;
+	g_event_watermark = 1;
+}
+
+/*
+* Signals g_event_fd once the available hits reach the watermark, then waits
+* until the user has read hits before checking the watermark again.
+*/
+void _event_thread_internal()
+{
+	std::unique_lock<std::mutex> lock(g_event_mutex);
+	while (!g_event_thread_stop)
+	{
+		if (g_event_signaled)
+		{
+			g_event_cv.wait(lock);
+			continue;
+		}
+
+		size_t watermark = g_event_watermark;
+		uint64_t read_count = g_event_read_count.load(std::memory_order_acquire);
+		// Two hits are written per millisecond, the write pointer is updated 
+		// dma_read_delay later
+		int64_t elapsed_ms = (_get_time_ns_internal() - g_event_dma_read_delay - g_event_base_fill_time) / 1000000;
+		uint64_t write_count = g_event_base_write_count + 2 * (uint64_t)elapsed_ms;
+		uint64_t available_hits = (write_count > read_count) ? (write_count - read_count) : 0;
+		if (available_hits > g_event_buffer_hits)
+		{
+			available_hits = g_event_buffer_hits;
+		}
+
+		if (available_hits >= watermark)
+		{
+#ifdef __linux__
+			uint64_t increment = 1;
+			if (write(g_event_fd, &increment, sizeof(increment)) < 0)
+			{
+				// Counter overflow, the descriptor is readable anyway
+			}
+#endif
+			g_event_signaled = true;
+			continue;
+		}
+
+		int64_t missing_ms = (int64_t)((read_count + watermark - write_count + 1) / 2);
+		int64_t wake_up = g_event_base_fill_time + g_event_dma_read_delay + (elapsed_ms + missing_ms) * 1000000;
+		g_event_cv.wait_until(lock, std::chrono::steady_clock::time_point(
+			std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(wake_up))));
+	}
+}
+
+/*
+* Gets the contiguous hits available in the host buffer starting at the read position.
+* Returns the number of hits in the view.
+*/
+size_t _get_host_buffer_view_internal(const TDCHit** view)
+{
+	size_t read_index = (size_t)(mngr.dma_read_count % mngr.host_buffer_hits);
+	size_t available_hits = (size_t)(mngr.dma_write_count - mngr.dma_read_count);
+	size_t contiguous_hits = mngr.host_buffer_hits - read_index;
+
+	*view = mngr.host_buffer + read_index;
+	return (available_hits < contiguous_hits) ? available_hits : contiguous_hits;
+}
+
+TDCHit* _get_host_buffer_hit_internal(uint64_t position)
+{
+	return &(mngr.host_buffer[position % mngr.host_buffer_hits]);
+}
+
+/*
+* Emulates the grouping engine of the driver. Searches the host buffer for the next 
+* trigger that creates a group, returns false if there is no complete group yet. 
+* A group is complete when a hit after its range has been written by the DMA engine.
+*/
+bool _find_group_internal(dummy_group* group)
+{
+	const xhptdc8_grouping_configuration* grouping = &(mngr.p_mgr_cfg.grouping);
+	uint64_t trigger_channels = grouping->trigger_channel_bitmask | (1ULL << grouping->trigger_channel);
+
+	while (mngr.group_scan_count < mngr.dma_write_count)
+	{
+		const TDCHit* trigger = _get_host_buffer_hit_internal(mngr.group_scan_count);
+		_release_group_hits_internal(trigger->time);
+		if (trigger->channel >= 64 || !((trigger_channels >> trigger->channel) & 1) ||
+			(mngr.group_has_trigger && 
+				(trigger->time - mngr.group_last_trigger_time < grouping->trigger_deadtime)))
+		{
+			mngr.group_scan_count++;
+			continue;
+		}
+
+		uint64_t last = mngr.group_scan_count;
+		while (last < mngr.dma_write_count &&
+			_get_host_buffer_hit_internal(last)->time - trigger->time <= grouping->range_stop)
+		{
+			last++;
+		}
+		if (last == mngr.dma_write_count)
+		{
+			return false;
+		}
+		uint64_t first = mngr.group_scan_count;
+		while (first > mngr.dma_read_count &&
+			_get_host_buffer_hit_internal(first - 1)->time - trigger->time >= grouping->range_start)
+		{
+			first--;
+		}
+		while (first < last && 
+			_get_host_buffer_hit_internal(first)->time - trigger->time < grouping->range_start)
+		{
+			first++;
+		}
+
+		group->start = first;
+		group->first = first;
+		group->last = last;
+		group->trigger = mngr.group_scan_count;
+		group->trigger_time = trigger->time;
+		group->zero_time = trigger->time;
+		bool has_window_hit = (0 == grouping->window_hit_channels);
+		bool has_zero_hit = false;
+		size_t trigger_hits = 0;
+		for (uint64_t position = first; position < last; position++)
+		{
+			const TDCHit* hit = _get_host_buffer_hit_internal(position);
+			if (position == group->trigger)
+			{
+				trigger_hits = 1;
+			}
+			if (!has_zero_hit && hit->channel == grouping->zero_channel)
+			{
+				// The first hit of zero_channel replaces the trigger as reference
+				group->zero_time = hit->time;
+				has_zero_hit = true;
+			}
+			if (hit->channel < 64 && ((grouping->window_hit_channels >> hit->channel) & 1) &&
+				hit->time - trigger->time >= grouping->window_start &&
+				hit->time - trigger->time <= grouping->window_stop)
+			{
+				has_window_hit = true;
+			}
+		}
+		if (!has_window_hit || (grouping->ignore_empty_events && (last - first) == trigger_hits))
+		{
+			// The trigger is recognized but does not create a group
+			_consume_group_internal(group, false);
+			continue;
+		}
+		// Skip the hits of a partially read group
+		group->first += mngr.group_read_hits;
+		return true;
+	}
+	return false;
+}
+
+/*
+* Marks the trigger of the group as processed, the next search starts after it.
+* created is false if the trigger did not create a group.
+*/
+void _consume_group_internal(const dummy_group* group, bool created)
+{
+	mngr.group_sequence += created;
+	mngr.group_has_trigger = true;
+	mngr.group_last_trigger_time = group->trigger_time;
+	mngr.group_scan_count = group->trigger + 1;
+	mngr.group_read_hits = 0;
+}
+
+/*
+* Copies size hits of the group to hit_buf, the time is relative to the zero reference.
+*/
+void _copy_group_internal(const dummy_group* group, TDCHit* hit_buf, size_t size)
+{
+	int64_t offset = mngr.p_mgr_cfg.grouping.zero_channel_offset - group->zero_time;
+	for (size_t hit_index = 0; hit_index < size; hit_index++)
+	{
+		hit_buf[hit_index] = *_get_host_buffer_hit_internal(group->first + hit_index);
+		hit_buf[hit_index].time += offset;
+	}
+}
+
+/*
+* Sorts the hits of group into the rows of tdc_array in a single pass. Hits beyond 
+* number_of_hits per channel are discarded. The row and the counter are selected 
+* arithmetically, so the loop has no data dependent branches: discarded hits are 
+* written to a scratch slot and do not increment the counters.
+* ADC channel 9 of each card is merged into channel 8, the first ADC value of each 
+* card is stored in adc_value.
+*/
+int _fill_group_matrix_internal(const dummy_group* group, int32_t* hit_counter, int64_t* tdc_array,
+	int32_t* adc_counter, int32_t* adc_value, int32_t number_of_tdcs, int32_t number_of_hits)
+{
+	const uint32_t channel_count = (uint32_t)(number_of_tdcs * XHPTDC8_NOF_CHANNELS_PER_CARD);
+	int64_t offset = mngr.p_mgr_cfg.grouping.zero_channel_offset - group->zero_time;
+	int64_t scratch_time = 0;
+	int32_t scratch_counter = 0;
+	int32_t scratch_value = 0;
+	int hit_count = 0;
+	for (uint64_t position = group->first; position < group->last; position++)
+	{
+		const TDCHit* hit = _get_host_buffer_hit_internal(position);
+		uint32_t channel = hit->channel;
+		uint32_t card = channel / XHPTDC8_NOF_CHANNELS_PER_CARD;
+		uint32_t card_channel = channel - card * XHPTDC8_NOF_CHANNELS_PER_CARD;
+		channel -= (card_channel == 9);
+		uint32_t is_adc = (card_channel >= 8);
+		uint32_t in_range = (channel < channel_count);
+		// Out of range channels are counted on channel 0 and discarded below
+		channel *= in_range;
+		card *= in_range;
+
+		int32_t slot = hit_counter[channel];
+		uint32_t keep = in_range & (slot < number_of_hits);
+		int64_t* target = keep ? &tdc_array[(size_t)channel * number_of_hits + slot] : &scratch_time;
+		*target = hit->time + offset;
+		hit_counter[channel] = slot + keep;
+		hit_count += keep;
+
+		uint32_t keep_adc = keep & is_adc;
+		int32_t* counter = keep_adc ? &adc_counter[card] : &scratch_counter;
+		int32_t* value = (keep_adc & (0 == *counter)) ? &adc_value[card] : &scratch_value;
+		*value = hit->bin;
+		*counter += 1;
+	}
+	return hit_count;
+}
+
+/*
+* Fills header for group, of which the first length hits not read yet were copied. 
+* The counters and flags include the hits discarded and the hits already read by 
+* xhptdc8_read_group_part(). Must be called before the group is consumed, offset is 
+* set by the caller.
+*/
+void _fill_group_header_internal(const dummy_group* group, size_t length, xhptdc8_group_header* header)
+{
+	memset(header, 0, sizeof(xhptdc8_group_header));
+	header->length = length;
+	header->group_length = (size_t)(group->last - group->start);
+	header->part_read_hits = (size_t)(group->first - group->start);
+	header->trigger_timestamp = group->trigger_time;
+	header->zero_reference = group->zero_time - group->trigger_time;
+	header->sequence_number = mngr.group_sequence;
+	// Veto is not emulated, veto_dropped_hits stays 0
+	for (uint64_t position = group->start; position < group->last; position++)
+	{
+		const TDCHit* hit = _get_host_buffer_hit_internal(position);
+		if (hit->channel < XHPTDC8_GROUP_HEADER_CHANNELS)
+		{
+			header->channel_mask |= 1ULL << hit->channel;
+			header->channel_hits[hit->channel] += (header->channel_hits[hit->channel] < UINT16_MAX);
+		}
+		// All bits except the rising edge flag are error flags
+		header->flags |= hit->type & ~XHPTDC8_TDCHIT_TYPE_RISING;
+	}
+	if (length < (size_t)(group->last - group->first))
+	{
+		header->flags |= XHPTDC8_GROUP_FLAG_TRUNCATED;
+	}
+}
+
+/*
+* Releases the hits before the range of a trigger at trigger_time, they are not 
+* part of any group of this or a later trigger.
+*/
+void _release_group_hits_internal(int64_t trigger_time)
+{
+	uint64_t release_count = mngr.dma_read_count;
+	while (release_count < mngr.group_scan_count &&
+		_get_host_buffer_hit_internal(release_count)->time - trigger_time < mngr.p_mgr_cfg.grouping.range_start)
+	{
+		release_count++;
+	}
+	if (release_count > mngr.dma_read_count)
+	{
+		_advance_read_position_internal((size_t)(release_count - mngr.dma_read_count));
+	}
+}
+
+/*
+* The update delay of the DMA write pointer in nanoseconds, dma_read_delay is in multiples of 16 ns.
+*/
+int64_t _get_dma_read_delay_ns_internal()
+{
+	return (int64_t)mngr.params.dma_read_delay * 16;
+}
+
+/*
+* Monotonic time in nanoseconds.
+*/
+int64_t _get_time_ns_internal()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void _set_last_error_format_internal(const char* format, const char* argument1, const char* argument2,
+	const char* argument3)
 {
-	va_list arglist;
-	va_start(arglist, format);
-	vsnprintf(mngr.last_error_message, mngr.MaxErrorMessageSize, format, arglist);
-	va_end(arglist);
+	g_last_error.format = format;
+	g_last_error.arguments[0] = argument1;
+	g_last_error.arguments[1] = argument2;
+	g_last_error.arguments[2] = argument3;
+	g_last_error.system_error = 0;
+	g_last_error.formatted = false;
 }
 
 void _set_last_error_internal(const char* errString)
 {
-	_set_last_error_printf_internal("%s", errString);
+	_set_last_error_format_internal("%s", errString, NULL, NULL);
+}
+
+/*
+* Sets errString followed by the text of system_error, errno on Linux, GetLastError() on Windows.
+*/
+void _set_last_error_system_internal(const char* errString, unsigned long system_error)
+{
+	_set_last_error_format_internal("%s", errString, NULL, NULL);
+	g_last_error.system_error = system_error;
+}
+
+void _clear_last_error_internal()
+{
+	_set_last_error_format_internal(NULL, NULL, NULL, NULL);
+}
+
+/*
+* Formats the last error of the calling thread when it is requested for the first time.
+*/
+const char* _format_last_error_internal()
+{
+	if (g_last_error.formatted)
+	{
+		return g_last_error.message;
+	}
+	g_last_error.formatted = true;
+	g_last_error.message[0] = 0;
+	if (NULL == g_last_error.format)
+	{
+		return g_last_error.message;
+	}
+	int length = snprintf(g_last_error.message, DUMMY_ERROR_MESSAGE_SIZE, g_last_error.format,
+		g_last_error.arguments[0], g_last_error.arguments[1], g_last_error.arguments[2]);
+	if (0 != g_last_error.system_error && length >= 0 && length < DUMMY_ERROR_MESSAGE_SIZE)
+	{
+#ifdef _WIN32
+		snprintf(g_last_error.message + length, DUMMY_ERROR_MESSAGE_SIZE - length, " Error %lu.",
+			g_last_error.system_error);
+#else
+		snprintf(g_last_error.message + length, DUMMY_ERROR_MESSAGE_SIZE - length, " %s.",
+			strerror((int)g_last_error.system_error));
+#endif
+	}
+	return g_last_error.message;
 }
 
 const char* _GetManagerStateMessage(ManagerState::Enum code)
@@ -818,6 +3313,8 @@ const char* _GetManagerStateMessage(ManagerState::Enum code)
 		return XHPTDC8_MAN_MSG_CAPTURING;
 	case ManagerState::PAUSED:
 		return XHPTDC8_MAN_MSG_PAUSED;
+	case ManagerState::CONFIGURING:
+		return XHPTDC8_MAN_MSG_CONFIGURING;
 	}
 	return "unknown error";  // just in case no code matches
 }
@@ -14,6 +14,10 @@
 #define XHPTDC8_VETO_OUTSIDE	2
 
 #define DUMMY_DEVICES_COUNT		1	// MUST BE <= XHPTDC8_MANAGER_DEVICES_MAX
+#define DUMMY_DEFAULT_BUFFER_SIZE	(16 * 1024 * 1024)	// Used when buffer_size is 0
+#define DUMMY_PACKET_MAX_HITS		256		// Hits per packet of xhptdc8_read_packets()
+#define DUMMY_ERROR_MESSAGE_SIZE	512		// Formatted message of xhptdc8_get_last_error_message()
+#define DUMMY_ALIGNMENT_MS			20		// Emulated TDC alignment of a board by *_configure()
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,7 +30,8 @@ extern "C" {
 			INITIALIZED = 1,
 			CONFIGURED = 2,
 			CAPTURING = 3,
-			PAUSED = 4
+			PAUSED = 4,
+			CONFIGURING = 5		// Between *_configure_async() and applying its result
 		};
 	}
 
@@ -52,25 +57,72 @@ extern "C" {
 		DeviceState::Enum dev_state;
 		xhptdc8_manager_configuration p_mgr_cfg;
 		/*
-		In Milliseconds
+		Number of calls to xhptdc8_read_hits()
+		How many times *_read() has been called.
 		*/
-		long start_capture_time;
+		long read_hits_count;
+
 		/*
-		Saves time captured because of call of pause() or stop()
+		Host ring buffer emulating the DMA buffer, sized by params.buffer_size
 		*/
-		long captured_stored_time;
+		TDCHit* host_buffer;
+		size_t host_buffer_hits;
 		/*
-		Number of calls to xhptdc8_read_hits()
-		How many times *_read() has been called.
+		Size of the host buffer allocated in pages of params.buffer_pages, 0 if 
+		allocated with new
 		*/
-		long read_hits_count;
+		size_t host_buffer_mapped_bytes;
+		bool host_buffer_locked;
 		/*
-		Timestamp of calling *_read() function
+		Number of hits written by the emulated DMA engine and read by the user
+		since *_start_capture(). Ring buffer index is the count modulo host_buffer_hits.
 		*/
-		long last_read_time;
-
-		const static size_t MaxErrorMessageSize = 10000;
-		char last_error_message[MaxErrorMessageSize];
+		uint64_t dma_write_count;
+		uint64_t dma_read_count;
+		/*
+		Number of hits of the view returned by xhptdc8_acquire_hits() not yet released
+		*/
+		size_t acquired_hits;
+		/*
+		Time in nanoseconds up to which the DMA engine has written hits
+		*/
+		int64_t dma_fill_time;
+		/*
+		Number of milliseconds emulated by the DMA engine since *_start_capture()
+		*/
+		int64_t dma_emulated_ms;
+		/*
+		Set when hits were discarded because the host buffer was full
+		*/
+		bool host_buffer_full;
+		/*
+		Position of the next hit the emulated grouping engine checks for a trigger,
+		hits from dma_read_count on are kept as they can be part of later groups
+		*/
+		uint64_t group_scan_count;
+		/*
+		Time of the last recognized trigger, used for trigger_deadtime
+		*/
+		int64_t group_last_trigger_time;
+		bool group_has_trigger;
+		/*
+		Hits of the group at group_scan_count already read by xhptdc8_read_group_part()
+		*/
+		size_t group_read_hits;
+		/*
+		Number of groups created since *_start_capture()
+		*/
+		uint64_t group_sequence;
+		/*
+		Packet buffer of xhptdc8_read_packets(), positions are in 8 byte words.
+		Packets from packet_read_words to packet_write_words are not acknowledged, 
+		the last of them starts at packet_last_words.
+		*/
+		uint64_t* packet_buffer;
+		size_t packet_buffer_words;
+		size_t packet_read_words;
+		size_t packet_write_words;
+		size_t packet_last_words;
 
 		// Board user flash
 		uint8_t* user_flash = NULL;
@@ -80,15 +132,97 @@ extern "C" {
 
 	const char MSG_OK[3] = { "OK" };
 
+	/*
+	* Group found in the host buffer by the emulated grouping engine, positions are 
+	* counts as dma_write_count
+	*/
+	typedef struct {
+		uint64_t start;		// First hit of the group, including hits read by *_read_group_part()
+		uint64_t first;		// First hit of the group not read yet
+		uint64_t last;		// Hit after the last hit of the group
+		uint64_t trigger;	// Trigger hit
+		int64_t trigger_time;
+		int64_t zero_time;	// Reference of the relative hit times
+	} dummy_group;
+
+	/*
+	* Status returned by the info functions, so they can be called from any thread.
+	* The control thread publishes a copy with _publish_status_internal() whenever 
+	* it changes, any thread copies it with _read_status_internal().
+	*/
+	typedef struct {
+		DeviceState::Enum dev_state;
+		xhptdc8_static_info static_info;
+		int64_t total_buffer;
+		int numa_node;
+		uint64_t cpu_mask;
+		size_t callback_ring_hits;
+	} dummy_status;
+
+	/*
+	* Last error of a thread. Failing functions only store the format and its 
+	* arguments, which must be static strings, and the system error code, so the 
+	* error paths do not format. xhptdc8_get_last_error_message() formats the 
+	* message once when it is requested.
+	*/
+	typedef struct {
+		const char* format;		// NULL if there is no error
+		const char* arguments[3];
+		unsigned long system_error;	// errno or GetLastError() appended to the message, 0 if none
+		bool formatted;
+		char message[DUMMY_ERROR_MESSAGE_SIZE];
+	} dummy_last_error;
+
 #ifdef __cplusplus
 }
 #endif
 
 int _init_static_info_internal(xhptdc8_static_info* info);
 void _set_last_error_internal(const char* errString);
-void _set_last_error_printf_internal(const char* format, ...);
-int _read_hits_for_groups_internal(TDCHit* hit_buf, size_t size);
+void _set_last_error_format_internal(const char* format, const char* argument1, const char* argument2,
+	const char* argument3);
+void _set_last_error_system_internal(const char* errString, unsigned long system_error);
+void _clear_last_error_internal();
+void _configure_board_internal(xhptdc8_configure_handle* handle, int device_index);
+int _apply_configure_internal(xhptdc8_configure_handle* handle);
+const char* _format_last_error_internal();
+int _read_hits_for_groups_internal(TDCHit* hit_buf, size_t size, xhptdc8_group_desc* groups, xhptdc8_group_header* headers, size_t max_groups);
+bool _find_group_internal(dummy_group* group);
+void _consume_group_internal(const dummy_group* group, bool created);
+void _copy_group_internal(const dummy_group* group, TDCHit* hit_buf, size_t size);
+void _fill_group_header_internal(const dummy_group* group, size_t length, xhptdc8_group_header* header);
+int _fill_group_matrix_internal(const dummy_group* group, int32_t* hit_counter, int64_t* tdc_array,
+	int32_t* adc_counter, int32_t* adc_value, int32_t number_of_tdcs, int32_t number_of_hits);
+void _release_group_hits_internal(int64_t trigger_time);
 int _read_hits_for_NO_groups_internal(TDCHit* hit_buf, size_t size);
+int _alloc_host_buffer_internal();
+void _free_host_buffer_internal();
+void* _alloc_pages_internal(size_t* bytes);
+void _free_pages_internal(void* buffer, size_t bytes);
+int _get_host_buffer_numa_node_internal();
+void _free_demux_queues_internal();
+int _write_packets_internal();
+bool _has_hit_callback_internal();
+int _copy_init_parameters_internal(const xhptdc8_manager_init_parameters* params, xhptdc8_manager_init_parameters* init_params);
+bool _is_valid_cpu_mask_internal(uint64_t cpu_mask);
+int _start_callback_threads_internal();
+void _stop_callback_threads_internal();
+void _callback_reader_thread_internal();
+void _callback_thread_internal();
+void _reset_host_buffer_internal();
+void _fill_host_buffer_internal();
+size_t _get_host_buffer_view_internal(const TDCHit** view);
+TDCHit* _get_host_buffer_hit_internal(uint64_t position);
+void _advance_read_position_internal(size_t hits);
+void _count_read_call_internal();
+void _publish_status_internal();
+void _read_status_internal(dummy_status* status);
+int _start_event_thread_internal();
+void _stop_event_thread_internal();
+void _close_event_fd_internal();
+void _event_thread_internal();
+int64_t _get_dma_read_delay_ns_internal();
+int64_t _get_time_ns_internal();
 const char* _GetManagerStateMessage(ManagerState::Enum code);
 
 /**
@@ -98,17 +232,27 @@ const char* _GetManagerStateMessage(ManagerState::Enum code);
 
 #define CHECK_MANAGER_STATE(s)	\
 	{ if(mngr.state != (s)) 	\
-		{	_set_last_error_printf_internal("xHPTDC8Manager is %s: expected state is %s", \
-				_GetManagerStateMessage(mngr.state), _GetManagerStateMessage(s));	\
+		{	_set_last_error_format_internal("xHPTDC8Manager is %s: expected state is %s", \
+				_GetManagerStateMessage(mngr.state), _GetManagerStateMessage(s), NULL);	\
 			return XHPTDC8_WRONG_STATE; \
 		}	\
 	}
 #define CHECK_MANAGER_STATE_OR(s1, s2) \
 	{ if(! (mngr.state == (s1) || mngr.state == (s2)))	\
-		{	_set_last_error_printf_internal("xHPTDC8Manager is %s: expected state is %s or %s", \
+		{	_set_last_error_format_internal("xHPTDC8Manager is %s: expected state is %s or %s", \
 				_GetManagerStateMessage(mngr.state), _GetManagerStateMessage(s1), _GetManagerStateMessage(s2) ); \
 			return XHPTDC8_WRONG_STATE; \
 		}	\
 	}
 
+/**
+* The read functions must not be used while the callback threads read the hits
+*/
+#define CHECK_NO_HIT_CALLBACK() \
+	{ if (_has_hit_callback_internal()) \
+		{	_set_last_error_internal(ERR_MSG_HIT_CALLBACK_REGISTERED); \
+			return XHPTDC8_WRONG_STATE; \
+		}	\
+	}
+
 #endif
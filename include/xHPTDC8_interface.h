@@ -16,8 +16,13 @@
 #include <stdarg.h>
 #include <stddef.h>
 #endif
-// current version of the API
-#define XHPTDC8_API_VERSION 1
+/**
+ * current version of the API, also the version of
+ * xhptdc8_manager_init_parameters
+ * 2: buffer_pages and lock_buffer added to xhptdc8_manager_init_parameters
+ * 3: numa_node and cpu_mask added to xhptdc8_manager_init_parameters
+ */
+#define XHPTDC8_API_VERSION 3
 
 /**
  * current version of data structures used by the interface
@@ -26,11 +31,12 @@
  */
 #define XHPTDC8_STATIC_INFO_VERSION 1
 #define XHPTDC8_FAST_INFO_VERSION 2
-#define XHPTDC8_PARAM_INFO_VERSION 2
+#define XHPTDC8_PARAM_INFO_VERSION 3
 #define XHPTDC8_TEMP_INFO_VERSION 3
 #define XHPTDC8_CLOCK_INFO_VERSION 1
 #define XHPTDC8_DEVICE_CONFIG_VERSION 3
-#define XHPTDC8_MANAGER_CONFIG_VERSION 1
+#define XHPTDC8_MANAGER_CONFIG_VERSION 3
+#define XHPTDC8_READOUT_STATS_VERSION 1
 
 // The maximum number of boards supported by the device manager.
 #define XHPTDC8_MANAGER_DEVICES_MAX 6
@@ -52,6 +58,23 @@
 #define XHPTDC8_BUFFER_ALLOCATE 0
 #define XHPTDC8_BUFFER_USE_PHYSICAL 1
 
+/**
+ * Page size of the host buffer, see
+ * xhptdc8_manager_init_parameters::buffer_pages.
+ * Huge pages must be reserved by the system administrator, on Linux e.g. in
+ * /sys/kernel/mm/hugepages. On Windows only XHPTDC8_BUFFER_PAGES_2MB is
+ * supported and the user needs the "Lock pages in memory" privilege.
+ */
+#define XHPTDC8_BUFFER_PAGES_DEFAULT 0
+#define XHPTDC8_BUFFER_PAGES_2MB 1
+#define XHPTDC8_BUFFER_PAGES_1GB 2
+
+/**
+ * Unit of TDCHit::time, see xhptdc8_manager_configuration::time_unit.
+ */
+#define XHPTDC8_TIME_UNIT_PS 0
+#define XHPTDC8_TIME_UNIT_BINS 1
+
 // internal baseline of the AC coupled trigger signals
 // the input may swing between -1.32 V - +2 V
 #define XHPTDC8_INPUT_BASELINE +1.32
@@ -256,6 +279,41 @@ typedef struct {
      */
     crono_bool_t ignore_calibration;
 
+    /**
+     * Page size of the host buffer, one of XHPTDC8_BUFFER_PAGES_*.
+     * Huge pages reduce the TLB misses when reading large amounts of hits.
+     * buffer_size is rounded up to a multiple of the page size. If the pages
+     * cannot be allocated xhptdc8_init() fails with
+     * XHPTDC8_BUFFER_ALLOC_FAILED.
+     * Initialized to XHPTDC8_BUFFER_PAGES_DEFAULT by
+     * xhptdc8_get_default_init_parameters().
+     */
+    int buffer_pages;
+
+    /**
+     * Lock the host buffer in physical memory, so it is never paged out.
+     * On Linux the limit RLIMIT_MEMLOCK must allow the buffer size.
+     * Value is either 'true' or 'false'.
+     */
+    crono_bool_t lock_buffer;
+
+    /**
+     * NUMA node the host buffer of each device is allocated on, usually the
+     * node of the PCIe root complex of the device. -1 to let the operating
+     * system decide. Initialized to -1 by
+     * xhptdc8_get_default_init_parameters().
+     */
+    int numa_node[XHPTDC8_MANAGER_DEVICES_MAX];
+
+    /**
+     * CPUs the internal threads of the driver for each device may run on,
+     * bit n allows CPU n. 0 for no restriction. Should be CPUs of numa_node.
+     * xhptdc8_init() fails with XHPTDC8_INVALID_ARGUMENTS if the mask does
+     * not contain a CPU of the system. If a thread cannot be pinned when it
+     * is started, the function starting it fails.
+     */
+    uint64_t cpu_mask[XHPTDC8_MANAGER_DEVICES_MAX];
+
 } xhptdc8_manager_init_parameters;
 
 /**
@@ -311,8 +369,641 @@ typedef struct {
 XHPTDC8_API int xhptdc8_read_hits(TDCHit *hit_buf, size_t read_max);
 
 /**
- * TODO
+ * Get a read-only view of the hits available in the host buffer without
+ * copying them.
+ *
+ * The view points directly into the host ring buffer sized by
+ * xhptdc8_manager_init_parameters.buffer_size. It stays valid until the hits
+ * are released using xhptdc8_release_hits(). Hits in the view are not
+ * overwritten by the DMA engine before they are released.
+ * Calling this function again before releasing returns the same first hit,
+ * possibly with a larger count.
+ * The view is contiguous. At the end of the ring buffer less hits than
+ * available may be returned, the remaining hits are returned by the next call
+ * after the view has been released.
+ * Grouping must be disabled. A call to xhptdc8_read_hits() invalidates the
+ * view.
+ *
+ * @param view[out]. Pointer to the first available hit.
+ * @param count[out]. Number of hits in the view, 0 if no data is available.
+ *
+ * @returns XHPTDC8_OK in case of success, or error code in case of error.
+ */
+XHPTDC8_API int xhptdc8_acquire_hits(const TDCHit **view, size_t *count);
+
+/**
+ * Return hits of the view provided by xhptdc8_acquire_hits() to the host
+ * buffer so that the DMA engine can overwrite them.
+ * Hits are released in order starting with the first hit of the view.
+ *
+ * @param count[in]. Number of hits to release. Must not exceed the count of
+ * the acquired view.
+ *
+ * @returns XHPTDC8_OK in case of success, or error code in case of error.
+ */
+XHPTDC8_API int xhptdc8_release_hits(size_t count);
+
+/**
+ * Wait until hits are available instead of polling xhptdc8_read_hits().
+ *
+ * The calling thread sleeps until the DMA write pointer has advanced so that
+ * at least min_hits hits are available in the host buffer, or until the
+ * timeout expires. Hits already available but not yet read or released are
+ * counted. As the write pointer is only updated after dma_read_delay, the
+ * wake-up is delayed accordingly.
+ * Grouping must be disabled.
+ *
+ * @param min_hits[in]. Number of hits to wait for. Must not exceed the
+ * capacity of the host buffer.
+ * @param timeout_ns[in]. Maximum time to wait in nanoseconds. If set to 0 the
+ * function returns immediately.
+ *
+ * @returns XHPTDC8_OK if at least min_hits hits are available,
+ * XHPTDC8_INSUFFICIENT_DATA if the timeout expired, or error code in case of
+ * error.
+ */
+XHPTDC8_API int xhptdc8_wait_for_hits(size_t min_hits, int64_t timeout_ns);
+
+/**
+ * Get a file descriptor that can be waited on with poll(), select() or epoll
+ * instead of polling xhptdc8_read_hits().
+ *
+ * The descriptor is an eventfd that becomes readable once the number of hits
+ * available in the host buffer reaches the watermark set by
+ * xhptdc8_set_event_watermark(). The user reads the 8 byte counter from the
+ * descriptor to reset it and then reads the hits. The descriptor is signaled
+ * again when hits are still above the watermark after the next read.
+ * The descriptor is owned by the driver, is valid until xhptdc8_close() and
+ * must not be closed by the user. Only supported on Linux.
+ *
+ * @param event_fd[out]. The file descriptor.
+ *
+ * @returns XHPTDC8_OK in case of success, or error code in case of error.
+ */
+XHPTDC8_API int xhptdc8_get_event_fd(int *event_fd);
+
+/**
+ * Set the number of available hits at which the descriptor returned by
+ * xhptdc8_get_event_fd() becomes readable. The default is 1.
+ *
+ * A larger watermark reduces the number of wake-ups at high rates at the cost
+ * of latency. The watermark can be changed while capturing.
+ *
+ * @param watermark_hits[in]. Number of hits, must be at least 1 and must not
+ * exceed the capacity of the host buffer.
+ *
+ * @returns XHPTDC8_OK in case of success, or error code in case of error.
+ */
+XHPTDC8_API int xhptdc8_set_event_watermark(size_t watermark_hits);
+
+/**
+ * Describes a group read by xhptdc8_read_groups().
+ */
+typedef struct {
+    /**
+     * Index of the first hit of the group in the hit buffer.
+     */
+    size_t offset;
+
+    /**
+     * Number of hits of the group.
+     */
+    size_t length;
+
+    /**
+     * The absolute time stamp of the trigger hit that created the group in
+     * picoseconds, continuously counting up from the call to start_capture().
+     */
+    int64_t trigger_timestamp;
+} xhptdc8_group_desc;
+
+/**
+ * Read multiple groups with a single call. Grouping must be enabled.
+ *
+ * The hits of the groups are stored one after the other in hit_buf, the
+ * position of each group is provided in groups. As many complete groups are
+ * read as fit in hit_buf and groups. If the first group is larger than
+ * hit_buf the remaining hits of that group are discarded, the same as for
+ * xhptdc8_read_hits(). Use xhptdc8_peek_group_size() and
+ * xhptdc8_read_group_part() to read large groups without losing hits.
+ *
+ * @param hit_buf[out]. Buffer allocated and provided by the user.
+ * @param buf_len[in]. Size of hit_buf in hits.
+ * @param groups[out]. Buffer allocated and provided by the user, a descriptor
+ * is written for every group read.
+ * @param max_groups[in]. Size of groups.
+ *
+ * @returns Returns the number of read groups.
+ */
+XHPTDC8_API int xhptdc8_read_groups(TDCHit *hit_buf, size_t buf_len,
+                                    xhptdc8_group_desc *groups,
+                                    size_t max_groups);
+
+/**
+ * Get the number of hits of the next group without reading it. Grouping must
+ * be enabled.
+ *
+ * If the next group was partially read by xhptdc8_read_group_part(), the
+ * number of hits not yet read is returned.
+ *
+ * @param hits[out]. Number of hits of the next group.
+ *
+ * @returns XHPTDC8_OK if a group is available, XHPTDC8_INSUFFICIENT_DATA if
+ * not, or error code in case of error.
+ */
+XHPTDC8_API int xhptdc8_peek_group_size(size_t *hits);
+
+/**
+ * Read the next group in parts. Grouping must be enabled.
+ *
+ * Reads up to buf_len hits of the next group. If the group does not fit in
+ * hit_buf, the next call continues with the remaining hits of the same group
+ * instead of discarding them, so hit_buf can be smaller than the largest
+ * group. The other read functions continue a partially read group as well.
+ *
+ * @param hit_buf[out]. Buffer allocated and provided by the user.
+ * @param buf_len[in]. Size of hit_buf in hits.
+ * @param trigger_timestamp[out]. The absolute time stamp of the trigger hit
+ * of the group in picoseconds.
+ * @param remaining[out]. Number of hits of the group left for the next
+ * call, 0 if the group is completely read.
+ *
+ * @returns Returns the number of read hits, or error code in case of error.
+ */
+XHPTDC8_API int xhptdc8_read_group_part(TDCHit *hit_buf, size_t buf_len,
+                                        int64_t *trigger_timestamp,
+                                        size_t *remaining);
+
+// Number of channels counted in xhptdc8_group_header::channel_hits
+#define XHPTDC8_GROUP_HEADER_CHANNELS                                          \
+    (XHPTDC8_MANAGER_DEVICES_MAX * XHPTDC8_NOF_CHANNELS_PER_CARD)
+// Flag of xhptdc8_group_header::flags, hits of the group were discarded
+// because hit_buf was too small.
+#define XHPTDC8_GROUP_FLAG_TRUNCATED 0x100
+
+/**
+ * Fixed size header of a group read by xhptdc8_read_group_headers().
+ */
+typedef struct {
+    /**
+     * Index of the first hit of the group in hit_buf.
+     */
+    size_t offset;
+
+    /**
+     * Number of hits of the group in hit_buf.
+     */
+    size_t length;
+
+    /**
+     * Number of hits of the whole group. Larger than length if
+     * XHPTDC8_GROUP_FLAG_TRUNCATED is set or part_read_hits is not 0.
+     * channel_mask, channel_hits and flags describe all hits of the group,
+     * including the discarded ones and the ones already read.
+     */
+    size_t group_length;
+
+    /**
+     * Number of the first hits of the group that were already read by
+     * xhptdc8_read_group_part() and are not in hit_buf. 0 unless reading the
+     * group was started with xhptdc8_read_group_part().
+     */
+    size_t part_read_hits;
+
+    /**
+     * The absolute time stamp of the trigger hit that created the group in
+     * picoseconds, continuously counting up from the call to start_capture().
+     */
+    int64_t trigger_timestamp;
+
+    /**
+     * Time of the zero reference of the hit time stamps relative to the
+     * trigger in picoseconds. 0 unless a hit of zero_channel was found, not
+     * including zero_channel_offset.
+     */
+    int64_t zero_reference;
+
+    /**
+     * Number of the group since start_capture(), starting at 0. A gap between
+     * the sequence numbers of consecutive groups shows groups that were not
+     * read with this function.
+     */
+    uint64_t sequence_number;
+
+    /**
+     * Bit n is set if the group contains hits of channel n.
+     */
+    uint64_t channel_mask;
+
+    /**
+     * Number of hits per channel, saturating at 65535.
+     */
+    uint16_t channel_hits[XHPTDC8_GROUP_HEADER_CHANNELS];
+
+    /**
+     * Number of hits in the range of the group that were removed by the veto.
+     */
+    uint32_t veto_dropped_hits;
+
+    /**
+     * The error flags XHPTDC8_TDCHIT_TYPE_ERROR_* of all hits of the group
+     * or'ed, and XHPTDC8_GROUP_FLAG_TRUNCATED.
+     */
+    uint32_t flags;
+} xhptdc8_group_header;
+
+/**
+ * Read multiple groups with a header each. Grouping must be enabled.
+ *
+ * The same as xhptdc8_read_groups(), but a header with the trigger, the
+ * per-channel hit counts and the error flags is written for every group, so
+ * groups can be skipped or routed without scanning their hits.
+ *
+ * @param hit_buf[out]. Buffer allocated and provided by the user.
+ * @param buf_len[in]. Size of hit_buf in hits.
+ * @param headers[out]. Buffer allocated and provided by the user, a header
+ * is written for every group read.
+ * @param max_groups[in]. Size of headers.
+ *
+ * @returns Returns the number of read groups.
+ */
+XHPTDC8_API int xhptdc8_read_group_headers(TDCHit *hit_buf, size_t buf_len,
+                                           xhptdc8_group_header *headers,
+                                           size_t max_groups);
+
+/**
+ * Read hits into separate arrays per field of TDCHit instead of an array of
+ * TDCHit, so that the data can be processed with SIMD instructions without
+ * reordering it first. Grouping must be disabled.
+ *
+ * All available data is read up to max hits. Hit i is stored at index i of
+ * every array. Arrays set to NULL are skipped, the corresponding field of
+ * the read hits is discarded.
+ *
+ * @param time[out]. Buffer for TDCHit::time of at least max entries, or NULL.
+ * @param channel[out]. Buffer for TDCHit::channel of at least max entries,
+ * or NULL.
+ * @param type[out]. Buffer for TDCHit::type of at least max entries, or NULL.
+ * @param bin[out]. Buffer for TDCHit::bin of at least max entries, or NULL.
+ * @param max[in]. Maximum number of hits to read.
+ *
+ * @returns Returns the number of read hits.
+ */
+XHPTDC8_API int xhptdc8_read_hits_soa(int64_t *time, uint8_t *channel,
+                                      uint8_t *type, uint16_t *bin,
+                                      size_t max);
+
+/**
+ * Packed hit format of xhptdc8_read_hits_packed().
+ *
+ * Every hit is stored in a 64 bit word. The time of a hit is stored as the
+ * difference to the previous hit. Anchor words store the absolute time that
+ * the difference of the next hit refers to:
+ *
+ * Anchor word: bit 63 set, bits 62..0 absolute time in picoseconds.
+ * Hit word:    bit 63 clear, bits 62..56 channel, bits 55..48 type,
+ *              bits 47..32 bin, bits 31..0 time difference in picoseconds.
+ *
+ * The data of every read starts with an anchor. Another anchor is inserted
+ * whenever the time difference to the previous hit is negative or does not
+ * fit in 32 bits. Use xhptdc8_unpack_hits() of the util library to decode
+ * the data into TDCHit.
+ */
+#define XHPTDC8_PACKED_ANCHOR_FLAG 0x8000000000000000ULL
+#define XHPTDC8_PACKED_MAX_DELTA 0xFFFFFFFFULL
+
+#define XHPTDC8_PACKED_IS_ANCHOR(word)                                         \
+    (((word) & XHPTDC8_PACKED_ANCHOR_FLAG) != 0)
+#define XHPTDC8_PACKED_ANCHOR_TIME(word)                                       \
+    ((int64_t)((word) & ~XHPTDC8_PACKED_ANCHOR_FLAG))
+#define XHPTDC8_PACKED_CHANNEL(word) ((uint8_t)(((word) >> 56) & 0x7F))
+#define XHPTDC8_PACKED_TYPE(word) ((uint8_t)(((word) >> 48) & 0xFF))
+#define XHPTDC8_PACKED_BIN(word) ((uint16_t)(((word) >> 32) & 0xFFFF))
+#define XHPTDC8_PACKED_DELTA(word) ((uint32_t)((word) & 0xFFFFFFFF))
+
+#define XHPTDC8_PACKED_ANCHOR(time)                                            \
+    (XHPTDC8_PACKED_ANCHOR_FLAG | ((uint64_t)(time) & ~XHPTDC8_PACKED_ANCHOR_FLAG))
+#define XHPTDC8_PACKED_HIT(channel, type, bin, delta)                          \
+    ((((uint64_t)(channel) & 0x7F) << 56) | (((uint64_t)(type) & 0xFF) << 48) | \
+     (((uint64_t)(bin) & 0xFFFF) << 32) | ((uint64_t)(delta) & 0xFFFFFFFF))
+
+/**
+ * Read hits in the packed format, using 8 bytes per hit instead of the
+ * 16 bytes of TDCHit. See XHPTDC8_PACKED_ANCHOR_FLAG for the format.
+ * Grouping must be disabled.
+ *
+ * All available data is read as long as it fits in the buffer.
+ *
+ * @param word_buf[out]. Buffer allocated and provided by the user.
+ * @param max_words[in]. Size of the buffer in 64 bit words, at least 2.
+ *
+ * @returns Returns the number of words written, including anchors.
+ */
+XHPTDC8_API int xhptdc8_read_hits_packed(uint64_t *word_buf, size_t max_words);
+
+/**
+ * Read only the hits of the channels selected by a bitmask. Hits of other
+ * channels are discarded without copying them. Grouping must be disabled.
+ *
+ * All available data is read until hit_buf is full. Discarded hits do not
+ * take space in hit_buf.
+ *
+ * @param hit_buf[out]. Buffer allocated and provided by the user.
+ * @param read_max[in]. Size of the buffer.
+ * @param channel_mask[in]. Bit n selects hits with TDCHit::channel n, using
+ * the same numbering including board_id * 10 for the other boards.
+ * @param skipped[out]. Number of discarded hits, can be NULL.
+ *
+ * @returns Returns the number of read hits.
+ */
+XHPTDC8_API int xhptdc8_read_hits_masked(TDCHit *hit_buf, size_t read_max,
+                                         uint64_t channel_mask,
+                                         size_t *skipped);
+
+// Number of channel queues of the demultiplexer, one for every TDCHit::channel
+#define XHPTDC8_DEMUX_CHANNEL_COUNT                                            \
+    (XHPTDC8_MANAGER_DEVICES_MAX * XHPTDC8_NOF_CHANNELS_PER_CARD)
+
+// Queue of the demultiplexer for hits with a TDCHit::channel of
+// XHPTDC8_DEMUX_CHANNEL_COUNT or higher
+#define XHPTDC8_DEMUX_OTHER_CHANNELS XHPTDC8_DEMUX_CHANNEL_COUNT
+
+/**
+ * Enable the demultiplexer that sorts hits into one queue per channel, so
+ * that each channel can be processed by its own thread.
+ *
+ * xhptdc8_demux_hits() moves the hits from the host buffer to the queues,
+ * xhptdc8_read_channel_hits() reads the hits of a single channel. Hits with a
+ * channel outside of the per-channel queues are not dropped, they are moved
+ * to the queue XHPTDC8_DEMUX_OTHER_CHANNELS. Must not be called while
+ * capturing. Queues are emptied when enabled.
+ *
+ * @param hits_per_channel[in]. Capacity of each queue in hits, rounded up to
+ * a power of 2. 0 disables the demultiplexer and frees the queues.
+ *
+ * @returns XHPTDC8_OK in case of success, or error code in case of error.
+ */
+XHPTDC8_API int xhptdc8_enable_demux(size_t hits_per_channel);
+
+/**
+ * Move all available hits from the host buffer to the queues of their
+ * channels in a single pass. Grouping must be disabled.
  *
+ * If the queue of a hit is full, the function stops and the hit and all
+ * following hits stay in the host buffer until the queue has been read.
+ * Only a single thread may call this function.
+ *
+ * @returns Returns the number of hits moved to the queues.
+ */
+XHPTDC8_API int xhptdc8_demux_hits();
+
+/**
+ * Read hits from the queue of a single channel.
+ *
+ * The function is lock-free. It may be called concurrently with
+ * xhptdc8_demux_hits() and with calls for other channels, but only by a
+ * single thread per channel.
+ *
+ * @param channel[in]. Channel as in TDCHit::channel, less than
+ * XHPTDC8_DEMUX_CHANNEL_COUNT, or XHPTDC8_DEMUX_OTHER_CHANNELS for the hits of
+ * all higher channels.
+ * @param hit_buf[out]. Buffer allocated and provided by the user.
+ * @param read_max[in]. Size of the buffer.
+ *
+ * @returns Returns the number of read hits.
+ */
+XHPTDC8_API int xhptdc8_read_channel_hits(int channel, TDCHit *hit_buf,
+                                          size_t read_max);
+
+/**
+ * Get the raw packets written by the DMA engine instead of decoded hits, e.g.
+ * to store the denser packet stream and decode it later. Grouping must be
+ * disabled.
+ *
+ * Packets are of type CRONO_PACKET_TYPE_TDC_DATA. crono_packet::timestamp is
+ * the time of the packet in picoseconds, every entry of crono_packet::data is
+ * a hit word of the packed format, see XHPTDC8_PACKED_ANCHOR_FLAG, with the
+ * time difference relative to the packet timestamp. Use
+ * crono_next_packet() to get the next packet, or the packet iterator of the
+ * util library.
+ *
+ * The packets stay in the host buffer until they are released using
+ * xhptdc8_acknowledge_packets(). Packets not yet acknowledged are returned
+ * again by the next call. Pointers returned by a previous call are invalid
+ * after the next call.
+ *
+ * @param first_packet[out]. The first packet available.
+ * @param last_packet[out]. The last packet available, not the packet after
+ * it.
+ *
+ * @returns XHPTDC8_OK in case of success, XHPTDC8_INSUFFICIENT_DATA if no
+ * packet is available, or error code in case of error.
+ */
+XHPTDC8_API int xhptdc8_read_packets(volatile crono_packet **first_packet,
+                                     volatile crono_packet **last_packet);
+
+/**
+ * Release packets provided by xhptdc8_read_packets().
+ *
+ * @param packet[in]. The last packet to release, all packets before it are
+ * released as well. Must be one of the packets returned by the last call of
+ * xhptdc8_read_packets().
+ *
+ * @returns XHPTDC8_OK in case of success, XHPTDC8_INVALID_ARGUMENTS if packet
+ * is not the start of such a packet, or error code in case of error.
+ */
+XHPTDC8_API int xhptdc8_acknowledge_packets(volatile crono_packet *packet);
+
+/**
+ * Callback of xhptdc8_register_hit_callback().
+ *
+ * @param user_ctx[in]. The pointer passed to xhptdc8_register_hit_callback().
+ * @param hits[in]. The hits of the batch, only valid during the call.
+ * @param count[in]. Number of hits of the batch.
+ */
+typedef void (*xhptdc8_hit_callback)(void *user_ctx, const TDCHit *hits,
+                                     size_t count);
+
+/**
+ * Register a callback that is called with batches of hits instead of polling
+ * xhptdc8_read_hits(). Grouping must be disabled.
+ *
+ * While capturing, a reader thread of the driver moves the hits from the
+ * host buffer to a ring of 64 * batch_hint hits, and a callback thread calls
+ * the callback with the hits of the ring. If the callback does not keep up
+ * and the ring is full, new hits are dropped and counted in
+ * xhptdc8_callback_stats. Partially filled batches are delivered after 1 ms.
+ * The read functions of the driver must not be used while a callback is
+ * registered. Must not be called while capturing.
+ *
+ * @param callback[in]. The callback, NULL to unregister the callback.
+ * @param user_ctx[in]. Passed to the callback.
+ * @param batch_hint[in]. Maximum number of hits passed to a single call of
+ * the callback.
+ *
+ * @returns XHPTDC8_OK in case of success, or error code in case of error.
+ */
+XHPTDC8_API int xhptdc8_register_hit_callback(xhptdc8_hit_callback callback,
+                                              void *user_ctx,
+                                              size_t batch_hint);
+
+/**
+ * Set the CPUs the reader thread and the callback thread of
+ * xhptdc8_register_hit_callback() may run on. Applied the next time the
+ * threads are started by xhptdc8_start_capture() or
+ * xhptdc8_continue_capture().
+ *
+ * @param reader_cpu_mask[in]. Bit n allows CPU n for the reader thread, 0 for
+ * no restriction.
+ * @param callback_cpu_mask[in]. Bit n allows CPU n for the callback thread,
+ * 0 for no restriction.
+ *
+ * @returns XHPTDC8_OK in case of success, XHPTDC8_INVALID_ARGUMENTS if a mask
+ * does not contain a CPU of the system, or error code in case of error.
+ * xhptdc8_start_capture() and xhptdc8_continue_capture() fail if a thread
+ * cannot be pinned to its CPUs.
+ */
+XHPTDC8_API int xhptdc8_set_callback_affinity(uint64_t reader_cpu_mask,
+                                              uint64_t callback_cpu_mask);
+
+/**
+ * Statistics of the hit callback since xhptdc8_start_capture().
+ */
+typedef struct {
+    /**
+     * Number of hits passed to the callback.
+     */
+    uint64_t delivered_hits;
+
+    /**
+     * Number of hits dropped because the ring was full.
+     */
+    uint64_t dropped_hits;
+
+    /**
+     * Number of calls of the callback.
+     */
+    uint64_t callback_calls;
+
+    /**
+     * Capacity of the ring in hits.
+     */
+    uint64_t ring_size;
+
+    /**
+     * Maximum number of hits in the ring.
+     */
+    uint64_t max_ring_fill;
+} xhptdc8_callback_stats;
+
+/**
+ * Get the statistics of the hit callback.
+ *
+ * @param stats[out]. Structure allocated by the user.
+ *
+ * @returns XHPTDC8_OK in case of success, or error code in case of error.
+ */
+XHPTDC8_API int xhptdc8_get_callback_stats(xhptdc8_callback_stats *stats);
+
+/**
+ * Readout statistics of a board. The counters count since xhptdc8_init() and
+ * never decrease, so rates are the differences of two calls of
+ * xhptdc8_get_readout_stats() divided by the time between them.
+ */
+typedef struct {
+    /**
+     * The number of bytes occupied by the structure.
+     */
+    int size;
+
+    /**
+     * A version number that is increased when the definition of the
+     * structure is changed.
+     *
+     * Set to XHPTDC8_READOUT_STATS_VERSION.
+     */
+    int version;
+
+    /**
+     * Number of hits written to the host buffer by the DMA engine.
+     */
+    uint64_t written_hits;
+
+    /**
+     * Number of hits taken from the host buffer by the read functions or the
+     * reader thread of xhptdc8_register_hit_callback(). With grouping this
+     * includes the hits outside of groups.
+     */
+    uint64_t delivered_hits;
+
+    /**
+     * Number of hits discarded because the host buffer was full. The next
+     * hit written is flagged with XHPTDC8_TDCHIT_TYPE_ERROR_HOST_BUFFER_FULL.
+     */
+    uint64_t lost_hits_host_buffer_full;
+
+    /**
+     * Number of hits discarded on the board because the DMA FIFO was full,
+     * flagged with XHPTDC8_TDCHIT_TYPE_ERROR_DMA_FIFO_FULL.
+     */
+    uint64_t lost_hits_dma_fifo_full;
+
+    /**
+     * Number of packets lost on the board, flagged with
+     * XHPTDC8_TDCHIT_TYPE_ERROR_PACKETS_LOST.
+     */
+    uint64_t lost_packets;
+
+    /**
+     * Number of hits dropped because the ring of
+     * xhptdc8_register_hit_callback() was full, see xhptdc8_callback_stats.
+     */
+    uint64_t lost_hits_callback_ring;
+
+    /**
+     * Number of calls of the read functions.
+     */
+    uint64_t read_calls;
+
+    /**
+     * Size of the host buffer in hits.
+     */
+    uint64_t host_buffer_hits;
+
+    /**
+     * Number of hits in the host buffer not yet taken.
+     */
+    uint64_t host_buffer_fill;
+
+    /**
+     * Maximum of host_buffer_fill, the high-water mark of the host buffer.
+     */
+    uint64_t host_buffer_max_fill;
+} xhptdc8_readout_stats;
+
+/**
+ * Get the readout statistics of a board, e.g. to size
+ * xhptdc8_manager_init_parameters::buffer_size and the cadence of the reader.
+ * The counters are updated by the thread reading the hits without a lock and
+ * read without a lock, so this function can be polled at kHz rates from a
+ * monitoring thread while capturing. The fields are read one by one, so
+ * host_buffer_fill can be off by the hits written meanwhile.
+ *
+ * @param index[in]. The index of the device.
+ * @param stats[out]. Structure allocated by the user.
+ *
+ * @returns XHPTDC8_OK in case of success, or error code in case of error.
+ */
+XHPTDC8_API int xhptdc8_get_readout_stats(int index, xhptdc8_readout_stats *stats);
+
+/**
+ * Read the next group into a matrix of timestamps per channel. Grouping must
+ * be enabled.
+ *
+ * The hits of the group are sorted by channel into the rows of tdc_array in
+ * a single pass, the timestamps are relative to the trigger as for
+ * xhptdc8_read_hits(). Hits beyond number_of_hits per channel are discarded.
+ * If no group is available, the counters are set to 0 and 0 is returned.
  *
  * @param absolute_trigger_timestamp[out]. The absolute trigger timestamp in
  *picoseconds.
@@ -330,15 +1021,16 @@ XHPTDC8_API int xhptdc8_read_hits(TDCHit *hit_buf, size_t read_max);
  *count is defined by number_of_hits. Set the buffer size to devices count (use
  *function xhptdc8_count_devices).
  * @param adc_value[out].			Buffer allocated and provded by
- *the user. This array provides the adc value per channel. The maximum is
- *defined by number_of_hits. Set the buffer size to devices count.
+ *the user. This array provides the value of the first adc hit per device.
+ *Set the buffer size to devices count.
  * @param number_of_tdcs[in].		This is the devices count that can be
  *calculated by the function xhptdc8_count_devices.
  * @param number_of_channels[in].	This has to be calculated by
  *XHPTDC8_NOF_CHANNELS_PER_CARD * number_of_tdcs.
  * @param number_of_hits[in].		This is used to define buffer sizes.
  *
- * @returns Returns the number of read hits.
+ * @returns Returns the number of hits stored in tdc_array, or error code in
+ *case of error.
  */
 XHPTDC8_API int xhptdc8_read_group_matrix(int64_t *absolute_trigger_timestamp, int32_t *hit_counter, int64_t *tdc_array,
                                           int32_t *adc_counter, int32_t *adc_value, int32_t number_of_tdcs,
@@ -413,6 +1105,29 @@ XHPTDC8_API int xhptdc8_stop_capture();
  */
 XHPTDC8_API int xhptdc8_software_trigger(int index);
 
+/*! \defgroup threading Threading model
+ *  \brief Functions that can be called while another thread reads the hits
+ *
+ * The functions that change the state of the boards, i.e. xhptdc8_init(),
+ * xhptdc8_configure(), the capture control functions,
+ * xhptdc8_register_hit_callback(), xhptdc8_clear_pcie_errors() and
+ * xhptdc8_close(), must be called from one control thread. One reader thread
+ * reads the hits, e.g. with xhptdc8_read_hits().
+ *
+ * Between xhptdc8_init() and xhptdc8_close() the status functions
+ * xhptdc8_get_static_info(), xhptdc8_get_fast_info(),
+ * xhptdc8_get_param_info(), xhptdc8_get_temperature_info(),
+ * xhptdc8_get_clock_info(), xhptdc8_get_pcie_info(),
+ * xhptdc8_get_readout_stats(), xhptdc8_get_callback_stats() and
+ * xhptdc8_get_current_timestamp() can be called from any number of threads
+ * concurrently with each other, the control thread and the reader thread.
+ * They take no lock: they copy a status the control thread publishes with a
+ * sequence lock, retrying while it is being written, or read counters that
+ * are updated atomically. A monitoring thread therefore never stalls the
+ * readout, and the application does not need to serialize it with the reader
+ * thread.
+ */
+
 /**
  * Fixed length of calibration date string.
  * calibration date format: YYYY-MM-DD hh:mm
@@ -671,6 +1386,17 @@ typedef struct {
      * The total amount of DMA buffer in bytes.
      */
     int64_t total_buffer;
+
+    /**
+     * NUMA node the DMA buffer is allocated on, -1 if unknown.
+     */
+    int numa_node;
+
+    /**
+     * CPUs the internal threads of the driver run on, see
+     * xhptdc8_manager_init_parameters::cpu_mask. 0 for no restriction.
+     */
+    uint64_t cpu_mask;
 } xhptdc8_param_info;
 
 /**
@@ -781,6 +1507,12 @@ XHPTDC8_API int xhptdc8_get_clock_info(int index, xhptdc8_clock_info *info);
 /**
  * Returns most recent error message.
  *
+ * The error is kept per thread, so the message describes the last error of a
+ * function called by the calling thread, and threads do not overwrite each
+ * other's messages. Failing functions only store the error, the message is
+ * formatted when it is requested. The returned string is valid until the
+ * calling thread calls this function again after another error.
+ *
  * @param index[in]. The index of the device. If set to -1 returns error message
  * of the manager.
  */
@@ -1185,6 +1917,11 @@ typedef struct {
 
 } xhptdc8_device_configuration;
 
+// Number of entries of xhptdc8_manager_configuration::channel_offset, one for
+// every TDCHit::channel
+#define XHPTDC8_CHANNEL_OFFSET_COUNT                                           \
+    (XHPTDC8_MANAGER_DEVICES_MAX * XHPTDC8_NOF_CHANNELS_PER_CARD)
+
 /**
  * Contains global configuration information.
  */
@@ -1219,6 +1956,31 @@ typedef struct {
      */
     int64_t (*bin_to_ps)(int64_t);
 
+    /**
+     * Unit of TDCHit::time, one of XHPTDC8_TIME_UNIT_*.
+     * With XHPTDC8_TIME_UNIT_BINS the driver skips the conversion of every
+     * hit and returns the raw TDC bins of xhptdc8_param_info::binsize.
+     * Histograms can be filled in bins directly, or the times are
+     * converted in bulk with xhptdc8_bins_to_ps() of the util library.
+     * Grouping requires XHPTDC8_TIME_UNIT_PS.
+     * Added with XHPTDC8_MANAGER_CONFIG_VERSION 2, drivers of an older
+     * version leave it uninitialized. xhptdc8_init_configuration() of the
+     * util library initializes it to XHPTDC8_TIME_UNIT_PS.
+     */
+    int time_unit;
+
+    /**
+     * Calibration offset in picoseconds of each channel, compensating e.g.
+     * cable delays and the offsets between the boards. Indexed like
+     * TDCHit::channel, i.e. board index * XHPTDC8_NOF_CHANNELS_PER_CARD +
+     * channel. The driver does not apply the offsets, the hits are corrected
+     * in bulk with xhptdc8_apply_channel_offsets() of the util library.
+     * Added with XHPTDC8_MANAGER_CONFIG_VERSION 3, drivers of an older
+     * version leave it uninitialized. xhptdc8_init_configuration() of the
+     * util library initializes it to 0.
+     */
+    int64_t channel_offset[XHPTDC8_CHANNEL_OFFSET_COUNT];
+
 } xhptdc8_manager_configuration;
 
 /**
@@ -1251,6 +2013,76 @@ XHPTDC8_API int xhptdc8_get_current_configuration(xhptdc8_manager_configuration
  */
 XHPTDC8_API int xhptdc8_configure(xhptdc8_manager_configuration *mgr_config);
 
+/**
+ * A configuration started by xhptdc8_configure_async().
+ */
+typedef struct xhptdc8_configure_handle_ xhptdc8_configure_handle;
+
+/**
+ * Starts to configure the xHPTDC8 manager and returns without waiting for the
+ * boards, e.g. for the TDC alignment. The boards are configured in parallel,
+ * so the time of a multiboard setup is about the time of the slowest board.
+ * The config information is copied, so can be changed afterwards.
+ *
+ * The arguments and the state are checked before returning. The
+ * configuration is applied when xhptdc8_configure_wait() returns its result,
+ * until then the other configuration and run time control functions return
+ * XHPTDC8_WRONG_STATE. xhptdc8_configure() is the same as this function
+ * followed by xhptdc8_configure_wait() and xhptdc8_release_configure().
+ *
+ * @param mgr_config[in].
+ * @param handle[out]. Handle of the configuration, must be released with
+ * xhptdc8_release_configure().
+ *
+ * @returns XHPTDC8_OK in case of success, or error code in case of error.
+ * XHPTDC8_INTERNAL_ERROR if a thread could not be started, then the state is
+ * unchanged and no handle is returned.
+ */
+XHPTDC8_API int xhptdc8_configure_async(xhptdc8_manager_configuration *mgr_config,
+                                        xhptdc8_configure_handle **handle);
+
+/**
+ * Waits for a configuration started by xhptdc8_configure_async() and
+ * applies it once all boards are configured.
+ *
+ * @param handle[in]. Handle returned by xhptdc8_configure_async().
+ * @param timeout_ns[in]. Maximum time to wait in nanoseconds. If set to 0 the
+ * function polls and returns immediately, if negative it waits until the
+ * configuration is finished.
+ *
+ * @returns The result of the configuration, i.e. XHPTDC8_OK or the error code
+ * of the first board that failed, XHPTDC8_INSUFFICIENT_DATA if the timeout
+ * expired before all boards were configured, or error code in case of error.
+ */
+XHPTDC8_API int xhptdc8_configure_wait(xhptdc8_configure_handle *handle, int64_t timeout_ns);
+
+/**
+ * Get a file descriptor that can be waited on with poll(), select() or epoll
+ * for the end of a configuration started by xhptdc8_configure_async().
+ *
+ * The descriptor is an eventfd that becomes readable once all boards are
+ * configured. xhptdc8_configure_wait() must be called afterwards to get the
+ * result and apply the configuration. The descriptor is owned by the handle,
+ * is valid until xhptdc8_release_configure() and must not be closed by the
+ * user. Only supported on Linux.
+ *
+ * @param handle[in]. Handle returned by xhptdc8_configure_async().
+ * @param event_fd[out]. The file descriptor.
+ *
+ * @returns XHPTDC8_OK in case of success, or error code in case of error.
+ */
+XHPTDC8_API int xhptdc8_get_configure_event_fd(xhptdc8_configure_handle *handle, int *event_fd);
+
+/**
+ * Releases a handle returned by xhptdc8_configure_async(). Waits for the
+ * configuration and applies it if xhptdc8_configure_wait() has not returned
+ * its result yet.
+ *
+ * @param handle[in]. Handle returned by xhptdc8_configure_async(), may be
+ * NULL.
+ */
+XHPTDC8_API void xhptdc8_release_configure(xhptdc8_configure_handle *handle);
+
 /**
  * Returns the number of boards present in the system that are supported by this
  * driver.
@@ -1281,6 +2113,9 @@ XHPTDC8_API int xhptdc8_get_default_init_parameters(xhptdc8_manager_init_paramet
  *
  * @param init[in]. A structure of type xhptdc8_manager_init_parameters that
  * must be completely initialized.
+ * Only the members of params->version are read, later members are set to
+ * their defaults. Fails with XHPTDC8_INVALID_ARGUMENTS if the version is
+ * newer than XHPTDC8_API_VERSION.
  *
  * @returns XHPTDC8_OK in case of success, or error code in case of error.
  */
@@ -49,6 +49,16 @@ XHPTDC8_UTIL_API const char *xhptdc8_get_all_error_messages(crono_bool_t include
  */
 XHPTDC8_UTIL_API const char *xhptdc8_get_err_message(int err_code);
 
+/**
+ * Gets the default configuration with xhptdc8_get_default_configuration() and initializes the members the driver
+ * does not know, depending on the `version` it reports: `time_unit` to XHPTDC8_TIME_UNIT_PS for versions below 2,
+ * and `channel_offset` to 0 for versions below 3.
+ * Should be used instead of xhptdc8_get_default_configuration() before xhptdc8_apply_yaml().
+ *
+ * @returns XHPTDC8_OK, XHPTDC8_INVALID_ARGUMENTS, or the error code of xhptdc8_get_default_configuration().
+ */
+XHPTDC8_UTIL_API int xhptdc8_init_configuration(xhptdc8_manager_configuration *mgr_cfg);
+
 /**
  * Modifiy config sturcture to use grouping mode
  */
@@ -62,8 +72,469 @@ XHPTDC8_UTIL_API int xhptdc8_update_config_for_grouping_mode(int index, xhptdc8_
                                                              crono_bool_t ingore_empty_events
 #endif
                                                             );
+
+/**
+ * Decodes hits read by xhptdc8_read_hits_packed() into TDCHit.
+ *
+ * @param words[in]: Packed data, must start with an anchor word.
+ * @param word_count[in]: Number of words in `words`.
+ * @param hit_buf[out]: Decoded hits, `reserved` is set to 0.
+ * @param max_hits[in]: Size of `hit_buf`. At most `word_count` hits are decoded.
+ *
+ * @returns number of decoded hits, or -1 if an argument is invalid or the data does not start with an anchor.
+ */
+XHPTDC8_UTIL_API int xhptdc8_unpack_hits(const uint64_t *words, size_t word_count, TDCHit *hit_buf, size_t max_hits);
+
+/**
+ * Decodes the hits of a packet read by xhptdc8_read_packets() into TDCHit.
+ *
+ * @param packet[in]: Packet of type CRONO_PACKET_TYPE_TDC_DATA.
+ * @param hit_buf[out]: Decoded hits, `reserved` is set to 0.
+ * @param max_hits[in]: Size of `hit_buf`. At most `packet->length` hits are decoded.
+ *
+ * @returns number of decoded hits, or -1 if an argument is invalid or the packet is not of type
+ * CRONO_PACKET_TYPE_TDC_DATA.
+ */
+XHPTDC8_UTIL_API int xhptdc8_unpack_packet(const crono_packet *packet, TDCHit *hit_buf, size_t max_hits);
+
+// Ring modes of xhptdc8_create_hit_ring()
+// One producer thread and one consumer thread.
+#define XHPTDC8_HIT_RING_SPSC 0
+// Any number of producer and consumer threads.
+#define XHPTDC8_HIT_RING_MPMC 1
+
+/**
+ * Lock-free ring of batches of TDCHit, used to pass hits from an acquisition thread to processing threads.
+ */
+typedef struct xhptdc8_hit_ring_ xhptdc8_hit_ring;
+
+/**
+ * Creates a ring of `batch_count` batches of up to `batch_hits` hits each.
+ *
+ * @param mode[in]: XHPTDC8_HIT_RING_SPSC or XHPTDC8_HIT_RING_MPMC.
+ * @param batch_count[in]: Number of batches, rounded up to a power of 2.
+ * @param batch_hits[in]: Maximum number of hits per batch.
+ *
+ * @returns the ring, or NULL if an argument is invalid or the memory allocation failed.
+ */
+XHPTDC8_UTIL_API xhptdc8_hit_ring *xhptdc8_create_hit_ring(int mode, size_t batch_count, size_t batch_hits);
+
+/**
+ * Frees a ring created by xhptdc8_create_hit_ring(). No thread may use the ring anymore.
+ */
+XHPTDC8_UTIL_API void xhptdc8_destroy_hit_ring(xhptdc8_hit_ring *ring);
+
+/**
+ * Claims a free batch to be written by the producer, e.g. by passing it to xhptdc8_read_hits().
+ * In XHPTDC8_HIT_RING_SPSC mode only one batch can be claimed at a time.
+ *
+ * @returns buffer of `batch_hits` hits, or NULL if the ring is full.
+ */
+XHPTDC8_UTIL_API TDCHit *xhptdc8_hit_ring_claim(xhptdc8_hit_ring *ring);
+
+/**
+ * Passes a batch claimed by xhptdc8_hit_ring_claim() to the consumers.
+ *
+ * @param batch[in]: The buffer returned by xhptdc8_hit_ring_claim().
+ * @param hit_count[in]: Number of hits written to the batch, at most `batch_hits`.
+ *
+ * @returns XHPTDC8_OK, or XHPTDC8_INVALID_ARGUMENTS.
+ */
+XHPTDC8_UTIL_API int xhptdc8_hit_ring_commit(xhptdc8_hit_ring *ring, TDCHit *batch, size_t hit_count);
+
+/**
+ * Gets the next batch committed by a producer without copying it.
+ * In XHPTDC8_HIT_RING_SPSC mode only one batch can be acquired at a time.
+ *
+ * @param hit_count[out]: Number of hits of the batch.
+ *
+ * @returns the hits of the batch, or NULL if the ring is empty.
+ */
+XHPTDC8_UTIL_API const TDCHit *xhptdc8_hit_ring_acquire(xhptdc8_hit_ring *ring, size_t *hit_count);
+
+/**
+ * Returns a batch acquired by xhptdc8_hit_ring_acquire() to the producers.
+ *
+ * @returns XHPTDC8_OK, or XHPTDC8_INVALID_ARGUMENTS.
+ */
+XHPTDC8_UTIL_API int xhptdc8_hit_ring_release(xhptdc8_hit_ring *ring, const TDCHit *batch);
+
+/**
+ * Copies `hit_count` hits into a new batch.
+ *
+ * @returns 1 if the batch was added, 0 if the ring is full, or XHPTDC8_INVALID_ARGUMENTS.
+ */
+XHPTDC8_UTIL_API int xhptdc8_hit_ring_push(xhptdc8_hit_ring *ring, const TDCHit *hits, size_t hit_count);
+
+/**
+ * Copies the next batch to `hit_buf` and releases it.
+ *
+ * @param max_hits[in]: Size of `hit_buf`, at least `batch_hits`.
+ *
+ * @returns number of hits of the batch, -1 if the ring is empty, or XHPTDC8_INVALID_ARGUMENTS.
+ */
+XHPTDC8_UTIL_API int xhptdc8_hit_ring_pop(xhptdc8_hit_ring *ring, TDCHit *hit_buf, size_t max_hits);
+
+/**
+ * Read loop running in its own thread, see xhptdc8_start_async_capture().
+ */
+typedef struct xhptdc8_async_capture_ xhptdc8_async_capture;
+
+/**
+ * Statistics of a read loop, returned by xhptdc8_stop_async_capture().
+ */
+typedef struct {
+    // Number of hits committed to the ring
+    uint64_t hits;
+    // Number of batches committed to the ring
+    uint64_t batches;
+    // Number of times the read loop waited because the ring was full
+    uint64_t ring_full;
+    // Error code returned by xhptdc8_read_hits() that stopped the loop, XHPTDC8_OK if stopped by the user
+    int error_code;
+} xhptdc8_async_capture_stats;
+
+/**
+ * Starts a thread that calls xhptdc8_read_hits() directly into batches of `ring` until
+ * xhptdc8_stop_async_capture() is called. Only batches with hits are committed, except for the batch claimed
+ * from a XHPTDC8_HIT_RING_MPMC ring when the thread is stopped, which is committed with 0 hits.
+ * xhptdc8_start_capture() must be called by the user. The thread is the only producer of an
+ * XHPTDC8_HIT_RING_SPSC ring.
+ *
+ * While no hits are available the thread sleeps in xhptdc8_wait_for_hits() if the driver provides it, and
+ * for a short time otherwise.
+ *
+ * @param ring[in]: Ring the hits are written to.
+ * @param cpu_mask[in]: Bit n allows CPU n for the thread, 0 for no restriction.
+ *
+ * @returns the read loop, or NULL if an argument is invalid, the thread could not be started or could not be
+ * restricted to `cpu_mask`, e.g. because it contains no CPU of the system. The thread does not read any hits
+ * in that case.
+ */
+XHPTDC8_UTIL_API xhptdc8_async_capture *xhptdc8_start_async_capture(xhptdc8_hit_ring *ring, uint64_t cpu_mask);
+
+/**
+ * Stops and frees a read loop started by xhptdc8_start_async_capture(). The hits already
+ * committed stay in the ring.
+ *
+ * @param stats[out]: Statistics of the read loop, can be NULL.
+ *
+ * @returns XHPTDC8_OK, or XHPTDC8_INVALID_ARGUMENTS.
+ */
+XHPTDC8_UTIL_API int xhptdc8_stop_async_capture(xhptdc8_async_capture *capture, xhptdc8_async_capture_stats *stats);
+
+/**
+ * Latency bound of xhptdc8_create_merger() in picoseconds for a given `dma_read_delay` of
+ * xhptdc8_manager_init_parameters: twice the maximum update delay of the write pointer of 32 ns per unit.
+ */
+#define XHPTDC8_MERGER_LATENCY(dma_read_delay) ((int64_t)(dma_read_delay) * 64000)
+
+/**
+ * Merges the hits of several boards into one stream sorted by time, see xhptdc8_create_merger().
+ */
+typedef struct xhptdc8_merger_ xhptdc8_merger;
+
+/**
+ * Creates a merger for the hits of `board_count` boards in multiboard operation.
+ *
+ * The hits of every board must be sorted by time, hits of different boards may arrive in any order. The hits
+ * are passed with xhptdc8_merger_push() and merged using a loser tree. A hit is returned by xhptdc8_merger_pop()
+ * once it can not be preceded by a hit not yet pushed: every board has a later hit pushed, or the hit is older
+ * than the newest pushed hit by more than `latency`.
+ *
+ * @param board_count[in]: Number of boards, 1 to XHPTDC8_MANAGER_DEVICES_MAX.
+ * @param latency[in]: Maximum delay in picoseconds between hits of different boards arriving at the host, e.g.
+ * XHPTDC8_MERGER_LATENCY(dma_read_delay).
+ *
+ * @returns the merger, or NULL if an argument is invalid or the memory allocation failed.
+ */
+XHPTDC8_UTIL_API xhptdc8_merger *xhptdc8_create_merger(int board_count, int64_t latency);
+
+/**
+ * Frees a merger created by xhptdc8_create_merger().
+ */
+XHPTDC8_UTIL_API void xhptdc8_destroy_merger(xhptdc8_merger *merger);
+
+/**
+ * Passes hits read by xhptdc8_read_hits() to the merger, the board of each hit is `channel` / 10.
+ *
+ * @returns number of hits added, hits of boards >= `board_count` are discarded, or XHPTDC8_INVALID_ARGUMENTS.
+ */
+XHPTDC8_UTIL_API int xhptdc8_merger_push(xhptdc8_merger *merger, const TDCHit *hits, size_t hit_count);
+
+/**
+ * Gets the merged hits that can not be preceded by hits pushed later.
+ *
+ * @param hit_buf[out]: Merged hits sorted by time.
+ * @param max_hits[in]: Size of `hit_buf`.
+ * @param flush[in]: Returns all pushed hits, e.g. after xhptdc8_stop_capture().
+ *
+ * @returns number of hits written to `hit_buf`, or XHPTDC8_INVALID_ARGUMENTS.
+ */
+XHPTDC8_UTIL_API int xhptdc8_merger_pop(xhptdc8_merger *merger, TDCHit *hit_buf, size_t max_hits, crono_bool_t flush);
+
+/**
+ * Host clocks of xhptdc8_get_clock_fit(): std::chrono::steady_clock (CLOCK_MONOTONIC on Linux) and
+ * std::chrono::system_clock (CLOCK_REALTIME on Linux).
+ */
+#define XHPTDC8_HOST_CLOCK_MONOTONIC 0
+#define XHPTDC8_HOST_CLOCK_REALTIME 1
+
+/**
+ * Linear mapping of the board time to a host clock, host_time + (t - board_time) * slope.
+ */
+typedef struct {
+    // Board time in picoseconds of the reference point, as xhptdc8_get_current_timestamp()
+    int64_t board_time;
+    // Host time in nanoseconds since the epoch of the host clock at board_time
+    int64_t host_time;
+    // Host nanoseconds per board picosecond, 0.001 if both clocks run at the same rate
+    double slope;
+    // Deviation of the board clock from the host clock in ppm, positive if the board clock is faster
+    double drift_ppm;
+    // Root mean square deviation of the samples from the fit in nanoseconds
+    double residual_ns;
+    // Number of samples of the fit
+    int sample_count;
+} xhptdc8_clock_fit;
+
+/**
+ * Samples the board time and the host clocks in its own thread, see xhptdc8_start_clock_correlation().
+ */
+typedef struct xhptdc8_clock_correlation_ xhptdc8_clock_correlation;
+
+/**
+ * Starts a thread that samples xhptdc8_get_current_timestamp() of board `index` together with the host clocks
+ * every `interval_ms` milliseconds. Each sample is the one with the shortest host time window of several calls.
+ * The fit is a least squares line through the last 64 samples, so it follows a drift of the board oscillator.
+ * xhptdc8_init() must have been called.
+ *
+ * @param index[in]: Index of the board.
+ * @param interval_ms[in]: Time between two samples, at least 1.
+ *
+ * @returns the correlation, or NULL if an argument is invalid or the thread could not be started.
+ */
+XHPTDC8_UTIL_API xhptdc8_clock_correlation *xhptdc8_start_clock_correlation(int index, int interval_ms);
+
+/**
+ * Stops the sampling thread and frees the correlation.
+ *
+ * @returns XHPTDC8_OK, or XHPTDC8_INVALID_ARGUMENTS.
+ */
+XHPTDC8_UTIL_API int xhptdc8_stop_clock_correlation(xhptdc8_clock_correlation *correlation);
+
+/**
+ * Gets the current fit of the board time to `host_clock`. The fit is a copy, so it can be used for bulk
+ * conversions with xhptdc8_board_to_host_ns() while the sampling continues.
+ *
+ * @param host_clock[in]: XHPTDC8_HOST_CLOCK_MONOTONIC or XHPTDC8_HOST_CLOCK_REALTIME.
+ * @param fit[out]: The fit.
+ *
+ * @returns XHPTDC8_OK, XHPTDC8_INSUFFICIENT_DATA if less than 2 samples are taken yet, or
+ * XHPTDC8_INVALID_ARGUMENTS.
+ */
+XHPTDC8_UTIL_API int xhptdc8_get_clock_fit(xhptdc8_clock_correlation *correlation, int host_clock,
+                                           xhptdc8_clock_fit *fit);
+
+/**
+ * Converts board times in picoseconds, e.g. `TDCHit.time` without grouping or the `time` array of
+ * xhptdc8_read_hits_soa(), to host times in nanoseconds. The loop has no branches, so it is vectorized by
+ * the compiler.
+ *
+ * @param fit[in]: Fit returned by xhptdc8_get_clock_fit().
+ * @param board_times[in]: `count` board times.
+ * @param host_times[out]: `count` host times, may be the same array as `board_times`.
+ */
+XHPTDC8_UTIL_API void xhptdc8_board_to_host_ns(const xhptdc8_clock_fit *fit, const int64_t *board_times,
+                                               int64_t *host_times, size_t count);
+
+/**
+ * Converts times in TDC bins, e.g. the `time` array of xhptdc8_read_hits_soa() with XHPTDC8_TIME_UNIT_BINS, to
+ * picoseconds rounded to the nearest picosecond. AVX-512 or AVX2 is used if the CPU supports it, the results are
+ * the same for all instruction sets. The results are exact as long as they fit into int64_t, i.e. for
+ * |bins| < 2^63 / binsize, about 7 * 10^17 bins or 106 days. Larger times wrap around.
+ *
+ * @param binsize[in]: Bin size in picoseconds, xhptdc8_param_info::binsize. Greater than 0 and less than 16.
+ * @param bins[in]: `count` times in bins.
+ * @param ps[out]: `count` times in picoseconds, may be the same array as `bins`.
+ *
+ * @returns XHPTDC8_OK, or XHPTDC8_INVALID_ARGUMENTS.
+ */
+XHPTDC8_UTIL_API int xhptdc8_bins_to_ps(double binsize, const int64_t *bins, int64_t *ps, size_t count);
+
+/**
+ * Converts `time` of hits read with XHPTDC8_TIME_UNIT_BINS to picoseconds in place, see xhptdc8_bins_to_ps().
+ *
+ * @returns XHPTDC8_OK, or XHPTDC8_INVALID_ARGUMENTS.
+ */
+XHPTDC8_UTIL_API int xhptdc8_hits_bins_to_ps(double binsize, TDCHit *hits, size_t hit_count);
+
+/**
+ * Adds the calibration offsets xhptdc8_manager_configuration::channel_offset to `time` of the hits, using
+ * `TDCHit.channel` as index into the offsets. AVX-512 or AVX2 gathers the offsets of several hits at once if the CPU
+ * supports it. Hits of channels without offset are not changed.
+ *
+ * The offsets can change the order of hits that are close in time. The hits are checked in the same pass, and only
+ * a batch that is not ordered by time afterwards is sorted again, keeping the order of equal times. So a batch of
+ * hits read by xhptdc8_read_hits() or a group can be passed as a whole.
+ *
+ * @param mgr_cfg[in]: Configuration with the offsets, initialized with xhptdc8_init_configuration() and loaded with
+ * xhptdc8_apply_yaml().
+ * @param reference_channel[in]: -1 for absolute times. For times relative to a reference, e.g. of a group, the
+ * `TDCHit.channel` of the reference: the offset of that channel is subtracted from all offsets.
+ * @param hits[in,out]: `hit_count` hits, corrected in place.
+ *
+ * @returns 0 if the hits are ordered by time, 1 if they were sorted again, or XHPTDC8_INVALID_ARGUMENTS.
+ */
+XHPTDC8_UTIL_API int xhptdc8_apply_channel_offsets(const xhptdc8_manager_configuration *mgr_cfg,
+                                                   int reference_channel, TDCHit *hits, size_t hit_count);
+
+/**
+ * Blocks of xhptdc8_device_configuration compared by xhptdc8_compare_configuration().
+ */
+// auto_trigger_period and auto_trigger_random_exponent
+#define XHPTDC8_CONFIG_BLOCK_AUTO_TRIGGER 0x01
+// trigger_threshold
+#define XHPTDC8_CONFIG_BLOCK_THRESHOLD 0x02
+// trigger
+#define XHPTDC8_CONFIG_BLOCK_TRIGGER 0x04
+// gating_block
+#define XHPTDC8_CONFIG_BLOCK_GATING 0x08
+// tiger_block
+#define XHPTDC8_CONFIG_BLOCK_TIGER 0x10
+// channel, the settings of the TDC chips
+#define XHPTDC8_CONFIG_BLOCK_CHANNEL 0x20
+// adc_channel
+#define XHPTDC8_CONFIG_BLOCK_ADC 0x40
+// alignment_source and alignment_off_state
+#define XHPTDC8_CONFIG_BLOCK_ALIGNMENT 0x80
+// Blocks that require the TDCs of the board to be aligned again
+#define XHPTDC8_CONFIG_BLOCKS_TIMING (XHPTDC8_CONFIG_BLOCK_CHANNEL | XHPTDC8_CONFIG_BLOCK_ALIGNMENT)
+// All blocks of a board
+#define XHPTDC8_CONFIG_BLOCKS_ALL 0xFF
+
+/**
+ * Blocks of xhptdc8_manager_configuration besides the boards compared by xhptdc8_compare_configuration().
+ */
+#define XHPTDC8_CONFIG_MANAGER_GROUPING 0x01
+#define XHPTDC8_CONFIG_MANAGER_TIME_UNIT 0x02
+#define XHPTDC8_CONFIG_MANAGER_CHANNEL_OFFSET 0x04
+
+/**
+ * Changes between two configurations, and what xhptdc8_configure_changes() applied.
+ */
+typedef struct {
+    // Changed blocks of each board, XHPTDC8_CONFIG_BLOCK_*
+    int device_blocks[XHPTDC8_MANAGER_DEVICES_MAX];
+    // Changed blocks of the manager, XHPTDC8_CONFIG_MANAGER_*
+    int manager_blocks;
+    // Set if xhptdc8_configure() was called, i.e. anything changed
+    crono_bool_t configured;
+    // Bit `index` is set if board `index` was aligned again
+    int aligned_devices;
+} xhptdc8_config_changes;
+
+/**
+ * Compares two configurations block by block. skip_alignment is not compared, as it only controls how a
+ * configuration is applied. `configured` and `aligned_devices` of `changes` are set to 0. `time_unit` is only
+ * compared if the `version` of `current` is at least 2, and `channel_offset` if it is at least 3, as drivers of
+ * older versions do not report them.
+ *
+ * @param current[in]: Configuration in use, e.g. of xhptdc8_get_current_configuration().
+ * @param mgr_cfg[in]: New configuration.
+ * @param changes[out]: The changed blocks.
+ *
+ * @returns XHPTDC8_OK, or XHPTDC8_INVALID_ARGUMENTS.
+ */
+XHPTDC8_UTIL_API int xhptdc8_compare_configuration(const xhptdc8_manager_configuration *current,
+                                                   const xhptdc8_manager_configuration *mgr_cfg,
+                                                   xhptdc8_config_changes *changes);
+
+/**
+ * Configures the manager with `mgr_cfg` like xhptdc8_configure(), but only if it differs from
+ * xhptdc8_get_current_configuration(), and aligns only the TDCs of boards with changed XHPTDC8_CONFIG_BLOCKS_TIMING.
+ * Changing e.g. a threshold or a gate window then takes the time of writing the configuration instead of a full
+ * alignment. If the manager was not configured yet, all blocks are reported as changed and the configuration is
+ * applied as given.
+ *
+ * The driver receives the whole configuration, with skip_alignment set for boards whose timing did not change.
+ * `mgr_cfg` is not modified.
+ *
+ * @param mgr_cfg[in]: New configuration.
+ * @param changes[out]: The changed blocks and what was applied, may be NULL.
+ *
+ * @returns XHPTDC8_OK, XHPTDC8_INVALID_ARGUMENTS, XHPTDC8_BUFFER_ALLOC_FAILED, or the error code of the driver.
+ */
+XHPTDC8_UTIL_API int xhptdc8_configure_changes(const xhptdc8_manager_configuration *mgr_cfg,
+                                               xhptdc8_config_changes *changes);
 #ifdef __cplusplus
 }
+
+/**
+ * Range of the packets read by xhptdc8_read_packets() or of a stored packet stream, usable in range based for loops:
+ *
+ *     for (const crono_packet &packet : xhptdc8_packet_range(first_packet, last_packet)) { ... }
+ *
+ * The size of every packet is checked against the end of the range, the iteration stops at a packet that does not
+ * fit completely into the range instead of reading beyond it.
+ */
+class xhptdc8_packet_range {
+  public:
+    class iterator {
+      public:
+        iterator(const uint8_t *current, const uint8_t *end) : current_(current), end_(end) { validate(); }
+
+        const crono_packet &operator*() const { return *reinterpret_cast<const crono_packet *>(current_); }
+        const crono_packet *operator->() const { return reinterpret_cast<const crono_packet *>(current_); }
+
+        iterator &operator++() {
+            current_ += crono_packet_bytes(operator->());
+            validate();
+            return *this;
+        }
+
+        bool operator==(const iterator &other) const { return current_ == other.current_; }
+        bool operator!=(const iterator &other) const { return current_ != other.current_; }
+
+      private:
+        // Moves to the end if the header or the data of the packet exceeds the range
+        void validate() {
+            size_t remaining_bytes = static_cast<size_t>(end_ - current_);
+            if ((remaining_bytes < sizeof(crono_packet_only_timestamp)) ||
+                (remaining_bytes < static_cast<size_t>(crono_packet_bytes(operator->())))) {
+                current_ = end_;
+            }
+        }
+
+        const uint8_t *current_;
+        const uint8_t *end_;
+    };
+
+    /**
+     * Range of the packets from `first_packet` to `last_packet` including both, as returned by xhptdc8_read_packets().
+     * Empty if either is NULL.
+     */
+    xhptdc8_packet_range(volatile crono_packet *first_packet, volatile crono_packet *last_packet)
+        : begin_(reinterpret_cast<const uint8_t *>(const_cast<crono_packet *>(first_packet))), end_(begin_) {
+        if (nullptr != first_packet && nullptr != last_packet && first_packet <= last_packet) {
+            end_ = reinterpret_cast<const uint8_t *>(const_cast<crono_packet *>(last_packet)) +
+                   crono_packet_bytes(last_packet);
+        }
+    }
+
+    /**
+     * Range of the packets stored in `size_bytes` bytes starting at `data`.
+     */
+    xhptdc8_packet_range(const void *data, size_t size_bytes)
+        : begin_(static_cast<const uint8_t *>(data)), end_(begin_ + size_bytes) {}
+
+    iterator begin() const { return iterator(begin_, end_); }
+    iterator end() const { return iterator(end_, end_); }
+
+  private:
+    const uint8_t *begin_;
+    const uint8_t *end_;
+};
 #endif
 
 #endif
@@ -100,14 +100,14 @@ pub const CRONO_PCIE_UNC_ECRC_ERROR: u32 = 524288;
 pub const CRONO_PCIE_UNC_UNSUPPORED_REQUEST_ERROR: u32 = 1048576;
 pub const CRONO_PCIE_CORRECTABLE_FLAG: u32 = 1;
 pub const CRONO_PCIE_UNCORRECTABLE_FLAG: u32 = 2;
-pub const XHPTDC8_API_VERSION: u32 = 1;
+pub const XHPTDC8_API_VERSION: u32 = 3;
 pub const XHPTDC8_STATIC_INFO_VERSION: u32 = 1;
 pub const XHPTDC8_FAST_INFO_VERSION: u32 = 2;
-pub const XHPTDC8_PARAM_INFO_VERSION: u32 = 2;
+pub const XHPTDC8_PARAM_INFO_VERSION: u32 = 3;
 pub const XHPTDC8_TEMP_INFO_VERSION: u32 = 3;
 pub const XHPTDC8_CLOCK_INFO_VERSION: u32 = 1;
 pub const XHPTDC8_DEVICE_CONFIG_VERSION: u32 = 3;
-pub const XHPTDC8_MANAGER_CONFIG_VERSION: u32 = 1;
+pub const XHPTDC8_MANAGER_CONFIG_VERSION: u32 = 3;
 pub const XHPTDC8_MANAGER_DEVICES_MAX: u32 = 6;
 pub const XHPTDC8_TDC_CHANNEL_COUNT: u32 = 8;
 pub const XHPTDC8_GATE_COUNT: u32 = 8;
@@ -115,6 +115,11 @@ pub const XHPTDC8_TIGER_COUNT: u32 = 9;
 pub const XHPTDC8_TRIGGER_COUNT: u32 = 16;
 pub const XHPTDC8_BUFFER_ALLOCATE: u32 = 0;
 pub const XHPTDC8_BUFFER_USE_PHYSICAL: u32 = 1;
+pub const XHPTDC8_BUFFER_PAGES_DEFAULT: u32 = 0;
+pub const XHPTDC8_BUFFER_PAGES_2MB: u32 = 1;
+pub const XHPTDC8_BUFFER_PAGES_1GB: u32 = 2;
+pub const XHPTDC8_TIME_UNIT_PS: u32 = 0;
+pub const XHPTDC8_TIME_UNIT_BINS: u32 = 1;
 pub const XHPTDC8_INPUT_BASELINE: f64 = 1.32;
 pub const XHPTDC8_THRESHOLD_P_NIM: f64 = 0.35;
 pub const XHPTDC8_THRESHOLD_P_CMOS: f64 = 1.18;
@@ -679,12 +684,35 @@ pub struct xhptdc8_manager_init_parameters {
     #[doc = " Ignore calibration values read from device flash."]
     #[doc = " Value is either 'true' or 'false'."]
     pub ignore_calibration: crono_bool_t,
+    #[doc = " Page size of the host buffer, one of XHPTDC8_BUFFER_PAGES_*."]
+    #[doc = " Huge pages reduce the TLB misses when reading large amounts of hits."]
+    #[doc = " buffer_size is rounded up to a multiple of the page size. If the pages"]
+    #[doc = " cannot be allocated xhptdc8_init() fails with"]
+    #[doc = " XHPTDC8_BUFFER_ALLOC_FAILED."]
+    #[doc = " Initialized to XHPTDC8_BUFFER_PAGES_DEFAULT by"]
+    #[doc = " xhptdc8_get_default_init_parameters()."]
+    pub buffer_pages: ::std::os::raw::c_int,
+    #[doc = " Lock the host buffer in physical memory, so it is never paged out."]
+    #[doc = " On Linux the limit RLIMIT_MEMLOCK must allow the buffer size."]
+    #[doc = " Value is either 'true' or 'false'."]
+    pub lock_buffer: crono_bool_t,
+    #[doc = " NUMA node the host buffer of each device is allocated on, usually the"]
+    #[doc = " node of the PCIe root complex of the device. -1 to let the operating"]
+    #[doc = " system decide. Initialized to -1 by"]
+    #[doc = " xhptdc8_get_default_init_parameters()."]
+    pub numa_node: [::std::os::raw::c_int; 6usize],
+    #[doc = " CPUs the internal threads of the driver for each device may run on,"]
+    #[doc = " bit n allows CPU n. 0 for no restriction. Should be CPUs of numa_node."]
+    #[doc = " xhptdc8_init() fails with XHPTDC8_INVALID_ARGUMENTS if the mask does"]
+    #[doc = " not contain a CPU of the system. If a thread cannot be pinned when it"]
+    #[doc = " is started, the function starting it fails."]
+    pub cpu_mask: [u64; 6usize],
 }
 #[test]
 fn bindgen_test_layout_xhptdc8_manager_init_parameters() {
     assert_eq!(
         ::std::mem::size_of::<xhptdc8_manager_init_parameters>(),
-        32usize,
+        112usize,
         concat!("Size of: ", stringify!(xhptdc8_manager_init_parameters))
     );
     assert_eq!(
@@ -794,6 +822,58 @@ fn bindgen_test_layout_xhptdc8_manager_init_parameters() {
             stringify!(ignore_calibration)
         )
     );
+    assert_eq!(
+        unsafe {
+            &(*(::std::ptr::null::<xhptdc8_manager_init_parameters>())).buffer_pages as *const _
+                as usize
+        },
+        32usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(xhptdc8_manager_init_parameters),
+            "::",
+            stringify!(buffer_pages)
+        )
+    );
+    assert_eq!(
+        unsafe {
+            &(*(::std::ptr::null::<xhptdc8_manager_init_parameters>())).lock_buffer as *const _
+                as usize
+        },
+        36usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(xhptdc8_manager_init_parameters),
+            "::",
+            stringify!(lock_buffer)
+        )
+    );
+    assert_eq!(
+        unsafe {
+            &(*(::std::ptr::null::<xhptdc8_manager_init_parameters>())).numa_node as *const _
+                as usize
+        },
+        40usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(xhptdc8_manager_init_parameters),
+            "::",
+            stringify!(numa_node)
+        )
+    );
+    assert_eq!(
+        unsafe {
+            &(*(::std::ptr::null::<xhptdc8_manager_init_parameters>())).cpu_mask as *const _
+                as usize
+        },
+        64usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(xhptdc8_manager_init_parameters),
+            "::",
+            stringify!(cpu_mask)
+        )
+    );
 }
 #[repr(C)]
 #[derive(Debug, Copy, Clone)]
@@ -893,6 +973,39 @@ extern "C" {
     #[doc = " @returns Returns the number of read hits."]
     pub fn xhptdc8_read_hits(hit_buf: *mut TDCHit, read_max: size_t) -> ::std::os::raw::c_int;
 }
+extern "C" {
+    #[doc = " Get a read-only view of the hits available in the host buffer without"]
+    #[doc = " copying them."]
+    #[doc = ""]
+    #[doc = " @param view[out]. Pointer to the first available hit."]
+    #[doc = " @param count[out]. Number of hits in the view, 0 if no data is available."]
+    #[doc = ""]
+    #[doc = " @returns XHPTDC8_OK in case of success, or error code in case of error."]
+    pub fn xhptdc8_acquire_hits(view: *mut *const TDCHit, count: *mut size_t) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Return hits of the view provided by xhptdc8_acquire_hits() to the host"]
+    #[doc = " buffer so that the DMA engine can overwrite them."]
+    #[doc = ""]
+    #[doc = " @param count[in]. Number of hits to release. Must not exceed the count of"]
+    #[doc = " the acquired view."]
+    #[doc = ""]
+    #[doc = " @returns XHPTDC8_OK in case of success, or error code in case of error."]
+    pub fn xhptdc8_release_hits(count: size_t) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Wait until hits are available instead of polling xhptdc8_read_hits()."]
+    #[doc = ""]
+    #[doc = " @param min_hits[in]. Number of hits to wait for. Must not exceed the"]
+    #[doc = " capacity of the host buffer."]
+    #[doc = " @param timeout_ns[in]. Maximum time to wait in nanoseconds. If set to 0 the"]
+    #[doc = " function returns immediately."]
+    #[doc = ""]
+    #[doc = " @returns XHPTDC8_OK if at least min_hits hits are available,"]
+    #[doc = " XHPTDC8_INSUFFICIENT_DATA if the timeout expired, or error code in case of"]
+    #[doc = " error."]
+    pub fn xhptdc8_wait_for_hits(min_hits: size_t, timeout_ns: i64) -> ::std::os::raw::c_int;
+}
 extern "C" {
     #[doc = " TODO"]
     #[doc = ""]
@@ -1445,12 +1558,17 @@ pub struct xhptdc8_param_info {
     pub channel_mask: ::std::os::raw::c_int,
     #[doc = " The total amount of DMA buffer in bytes."]
     pub total_buffer: i64,
+    #[doc = " NUMA node the DMA buffer is allocated on, -1 if unknown."]
+    pub numa_node: ::std::os::raw::c_int,
+    #[doc = " CPUs the internal threads of the driver run on, see"]
+    #[doc = " xhptdc8_manager_init_parameters::cpu_mask. 0 for no restriction."]
+    pub cpu_mask: u64,
 }
 #[test]
 fn bindgen_test_layout_xhptdc8_param_info() {
     assert_eq!(
         ::std::mem::size_of::<xhptdc8_param_info>(),
-        32usize,
+        48usize,
         concat!("Size of: ", stringify!(xhptdc8_param_info))
     );
     assert_eq!(
@@ -1518,6 +1636,26 @@ fn bindgen_test_layout_xhptdc8_param_info() {
             stringify!(total_buffer)
         )
     );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<xhptdc8_param_info>())).numa_node as *const _ as usize },
+        32usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(xhptdc8_param_info),
+            "::",
+            stringify!(numa_node)
+        )
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<xhptdc8_param_info>())).cpu_mask as *const _ as usize },
+        40usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(xhptdc8_param_info),
+            "::",
+            stringify!(cpu_mask)
+        )
+    );
 }
 extern "C" {
     #[doc = " Returns information that may change with configuration"]
@@ -2600,12 +2738,31 @@ pub struct xhptdc8_manager_configuration {
     pub grouping: xhptdc8_grouping_configuration,
     #[doc = " Reserved for future use. Do not change!"]
     pub bin_to_ps: ::std::option::Option<unsafe extern "C" fn(arg1: i64) -> i64>,
+    #[doc = " Unit of TDCHit::time, one of XHPTDC8_TIME_UNIT_*."]
+    #[doc = " With XHPTDC8_TIME_UNIT_BINS the driver skips the conversion of every"]
+    #[doc = " hit and returns the raw TDC bins of xhptdc8_param_info::binsize."]
+    #[doc = " Histograms can be filled in bins directly, or the times are"]
+    #[doc = " converted in bulk with xhptdc8_bins_to_ps() of the util library."]
+    #[doc = " Grouping requires XHPTDC8_TIME_UNIT_PS."]
+    #[doc = " Added with XHPTDC8_MANAGER_CONFIG_VERSION 2, drivers of an older"]
+    #[doc = " version leave it uninitialized. xhptdc8_init_configuration() of the"]
+    #[doc = " util library initializes it to XHPTDC8_TIME_UNIT_PS."]
+    pub time_unit: ::std::os::raw::c_int,
+    #[doc = " Calibration offset in picoseconds of each channel, compensating e.g."]
+    #[doc = " cable delays and the offsets between the boards. Indexed like"]
+    #[doc = " TDCHit::channel, i.e. board index * XHPTDC8_NOF_CHANNELS_PER_CARD +"]
+    #[doc = " channel. The driver does not apply the offsets, the hits are corrected"]
+    #[doc = " in bulk with xhptdc8_apply_channel_offsets() of the util library."]
+    #[doc = " Added with XHPTDC8_MANAGER_CONFIG_VERSION 3, drivers of an older"]
+    #[doc = " version leave it uninitialized. xhptdc8_init_configuration() of the"]
+    #[doc = " util library initializes it to 0."]
+    pub channel_offset: [i64; 60usize],
 }
 #[test]
 fn bindgen_test_layout_xhptdc8_manager_configuration() {
     assert_eq!(
         ::std::mem::size_of::<xhptdc8_manager_configuration>(),
-        3160usize,
+        3648usize,
         concat!("Size of: ", stringify!(xhptdc8_manager_configuration))
     );
     assert_eq!(
@@ -2674,6 +2831,31 @@ fn bindgen_test_layout_xhptdc8_manager_configuration() {
             stringify!(bin_to_ps)
         )
     );
+    assert_eq!(
+        unsafe {
+            &(*(::std::ptr::null::<xhptdc8_manager_configuration>())).time_unit as *const _ as usize
+        },
+        3160usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(xhptdc8_manager_configuration),
+            "::",
+            stringify!(time_unit)
+        )
+    );
+    assert_eq!(
+        unsafe {
+            &(*(::std::ptr::null::<xhptdc8_manager_configuration>())).channel_offset as *const _
+                as usize
+        },
+        3168usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(xhptdc8_manager_configuration),
+            "::",
+            stringify!(channel_offset)
+        )
+    );
 }
 extern "C" {
     #[doc = " Gets default manager configuration. Copies the default configuration to the"]
@@ -503,7 +503,7 @@ pub fn acquire(output_file:&mut String, is_binary: bool, hits_no: u32, files_no:
     // ____________________
     // Loop on output files
     let time_before = SystemTime::now();
-    let mut time_slept = 0 ;
+    let mut time_waited_ms : u128 = 0 ;
 
     for file_index in 0..files_no {
         // _________________________________________________
@@ -577,11 +577,28 @@ pub fn acquire(output_file:&mut String, is_binary: bool, hits_no: u32, files_no:
                 }
                 // Allow the PCI buffer to fill up a little
                 if read_hits_no < DEFAULT_MIN_HITS_TO_SLEEP {
-                    time_slept += DEFAULT_SLEEP_MS ;
-                    thread::sleep(time::Duration::from_millis(DEFAULT_SLEEP_MS));
+                    let wait_start = time::Instant::now();
+                    if cur_config.grouping.enabled == 0 {
+                        // Wait only until enough hits are written, at most DEFAULT_SLEEP_MS
+                        let ret = xhptdc8_wait_for_hits(DEFAULT_MIN_HITS_TO_SLEEP as size_t, 
+                            (DEFAULT_SLEEP_MS * 1_000_000) as i64) ;
+                        // A timeout only means that less hits arrived, they are read in the next iteration
+                        if ret != XHPTDC8_OK as i32 && ret != XHPTDC8_INSUFFICIENT_DATA as i32 {
+                            bar.finish();
+                            println!("{}: {}", "Error waiting for hits"/*.red()*/, ret.to_string()/*.red()*/);
+                            if started_capture {
+                                xhptdc8_stop_capture() ;
+                            }
+                            return -1 ;
+                        }
+                    } else {
+                        thread::sleep(time::Duration::from_millis(DEFAULT_SLEEP_MS));
+                    }
+                    let waited_ms = wait_start.elapsed().as_millis() ;
+                    time_waited_ms += waited_ms ;
                     if ENABLE_LOG {
-                        println!("Read Hits No {}, Slept {} ms ", 
-                            read_hits_no.to_string()/*.red()*/, DEFAULT_SLEEP_MS) ;
+                        println!("Read Hits No {}, Waited {} ms ", 
+                            read_hits_no.to_string()/*.red()*/, waited_ms) ;
                     }
                 }
             }
@@ -631,8 +648,8 @@ pub fn acquire(output_file:&mut String, is_binary: bool, hits_no: u32, files_no:
     bar.finish(); 
     unsafe {
         if ENABLE_LOG {
-            println!("Elapsed Time: {:?}, Total Slept: {}", 
-                time_before.elapsed(), time_slept.to_string()/*.red()*/);
+            println!("Elapsed Time: {:?}, Total Waited: {} ms", 
+                time_before.elapsed(), time_waited_ms.to_string()/*.red()*/);
         }
     }
     return 1 ;
@@ -656,8 +673,9 @@ pub fn display_footer() {
 
 impl Default for xhptdc8_manager_init_parameters {
     fn default () -> xhptdc8_manager_init_parameters {
-        xhptdc8_manager_init_parameters{version: 0, buffer_size:0, variant:0, device_type:0, dma_read_delay:0,
-            multiboard:0, use_ext_clock:0, ignore_calibration:0}
+        xhptdc8_manager_init_parameters{version: XHPTDC8_API_VERSION as i32, buffer_size:0, variant:0, device_type:0,
+            dma_read_delay:0, multiboard:0, use_ext_clock:0, ignore_calibration:0,
+            buffer_pages: XHPTDC8_BUFFER_PAGES_DEFAULT as i32, lock_buffer:0, numa_node:[-1; 6], cpu_mask:[0; 6]}
     }
 }
 
@@ -665,7 +683,8 @@ impl Default for xhptdc8_manager_configuration {
     fn default () -> xhptdc8_manager_configuration {
         xhptdc8_manager_configuration{version: 0, size:0, device_configs:[xhptdc8_device_configuration::default(); 6], 
             grouping: xhptdc8_grouping_configuration::default(), 
-            bin_to_ps: std::option::Option::None}
+            bin_to_ps: std::option::Option::None, time_unit: XHPTDC8_TIME_UNIT_PS as i32,
+            channel_offset: [0; 60]}
     }
 }
 
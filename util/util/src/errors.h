@@ -35,10 +35,12 @@
 #define XHPTDC8_APPLY_YAML_INVALID_CHANNEL_ENABLE -71        // Invalid "channel" value of "enable"
 #define XHPTDC8_APPLY_YAML_INVALID_CHANNEL_RISING -72        // Invalid "channel" value of "rising"
 #define XHPTDC8_APPLY_YAML_INVALID_CHANNEL_STRUCT -73        // "channel" is not an array map, or index is invalid
+#define XHPTDC8_APPLY_YAML_INVALID_CHANNEL_OFFSET -74        // Invalid "channel" value of "offset"
 #define XHPTDC8_APPLY_YAML_INVALID_ADC_CHANNEL_ENABLE -80    // Invalid "adc_channel" value of "enable"
 #define XHPTDC8_APPLY_YAML_INVALID_ADC_CHANNEL_WDRO -81      // Invalid "adc_channel" value of "watchdog_readout"
 #define XHPTDC8_APPLY_YAML_INVALID_ADC_CHANNEL_WDI -82       // Invalid "adc_channel" value of "watchdog_interval"
 #define XHPTDC8_APPLY_YAML_INVALID_ADC_CHANNEL_TRTHRESH -83  // Invalid "adc_channel" value of "trigger_threshold"
+#define XHPTDC8_APPLY_YAML_INVALID_ADC_CHANNEL_OFFSET -84    // Invalid "adc_channel" value of "offset"
 #define XHPTDC8_APPLY_YAML_INVALID_GROUPING_ENABLED -90      // Invalid "grouping" value of "enabled"
 #define XHPTDC8_APPLY_YAML_INVALID_GROUPING_TRIGCH -91       // Invalid "grouping" value of "trigger_channel"
 #define XHPTDC8_APPLY_YAML_INVALID_GROUPING_ZEROCH -92       // Invalid "grouping" value of "zero_channel"
@@ -126,6 +126,8 @@ const char *xhptdc8_get_err_message(int err_code) {
         return "'channel' is not an array map, or index is invalid";
     case XHPTDC8_APPLY_YAML_INVALID_CHANNEL_RISING:
         return "Invalid 'channel' value of 'rising'";
+    case XHPTDC8_APPLY_YAML_INVALID_CHANNEL_OFFSET:
+        return "Invalid 'channel' value of 'offset'";
     case XHPTDC8_APPLY_YAML_INVALID_CHANNEL_ENABLE:
         return "Invalid 'channel' value of 'enable'";
     case XHPTDC8_APPLY_YAML_ERR_CHANNELS_EXCEED_MAX:
@@ -154,6 +156,8 @@ const char *xhptdc8_get_err_message(int err_code) {
         return "Invalid 'adc_channel' value of 'watchdog_interval'";
     case XHPTDC8_APPLY_YAML_INVALID_ADC_CHANNEL_WDRO:
         return "Invalid 'adc_channel' value of 'watchdog_readout'";
+    case XHPTDC8_APPLY_YAML_INVALID_ADC_CHANNEL_OFFSET:
+        return "Invalid 'adc_channel' value of 'offset'";
     case XHPTDC8_APPLY_YAML_INVALID_GROUPING_VETO_STOP:
         return "Invalid 'grouping' value of 'veto_stop'";
     case XHPTDC8_APPLY_YAML_INVALID_GROUPING_VETO_START:
@@ -194,6 +198,24 @@ const char *xhptdc8_get_err_message(int err_code) {
 }
 
 
+int xhptdc8_init_configuration(xhptdc8_manager_configuration *mgr_cfg) {
+    if (nullptr == mgr_cfg) {
+        return XHPTDC8_INVALID_ARGUMENTS;
+    }
+    int result = xhptdc8_get_default_configuration(mgr_cfg);
+    if (XHPTDC8_OK != result) {
+        return result;
+    }
+    // Members added after the version of the driver are left uninitialized by it
+    if (mgr_cfg->version < 2) {
+        mgr_cfg->time_unit = XHPTDC8_TIME_UNIT_PS;
+    }
+    if (mgr_cfg->version < 3) {
+        memset(mgr_cfg->channel_offset, 0, sizeof(mgr_cfg->channel_offset));
+    }
+    return XHPTDC8_OK;
+}
+
 int xhptdc8_update_config_for_grouping_mode(int index, xhptdc8_manager_configuration *mgr_cfg, float threshold,
                                             int64_t range_start, int64_t range_stop, crono_bool_t rising /*=false*/,
                                             crono_bool_t ingore_empty_events /*=false*/) {
@@ -235,3 +257,47 @@ int xhptdc8_update_config_for_grouping_mode(int index, xhptdc8_manager_configura
 
     return CRONO_OK;
 }
+
+int xhptdc8_unpack_hits(const uint64_t *words, size_t word_count, TDCHit *hit_buf, size_t max_hits) {
+    if (nullptr == words || nullptr == hit_buf) {
+        return -1;
+    }
+    if (word_count > 0 && !XHPTDC8_PACKED_IS_ANCHOR(words[0])) {
+        return -1;
+    }
+
+    size_t hit_count = 0;
+    int64_t time = 0;
+    for (size_t word_index = 0; word_index < word_count && hit_count < max_hits; word_index++) {
+        uint64_t word = words[word_index];
+        if (XHPTDC8_PACKED_IS_ANCHOR(word)) {
+            time = XHPTDC8_PACKED_ANCHOR_TIME(word);
+            continue;
+        }
+        time += XHPTDC8_PACKED_DELTA(word);
+        hit_buf[hit_count].time = time;
+        hit_buf[hit_count].channel = XHPTDC8_PACKED_CHANNEL(word);
+        hit_buf[hit_count].type = XHPTDC8_PACKED_TYPE(word);
+        hit_buf[hit_count].bin = XHPTDC8_PACKED_BIN(word);
+        hit_buf[hit_count].reserved = 0;
+        hit_count++;
+    }
+    return static_cast<int>(hit_count);
+}
+
+int xhptdc8_unpack_packet(const crono_packet *packet, TDCHit *hit_buf, size_t max_hits) {
+    if (nullptr == packet || nullptr == hit_buf || CRONO_PACKET_TYPE_TDC_DATA != packet->type) {
+        return -1;
+    }
+
+    size_t hit_count = (packet->length < max_hits) ? packet->length : max_hits;
+    for (size_t hit_index = 0; hit_index < hit_count; hit_index++) {
+        uint64_t word = packet->data[hit_index];
+        hit_buf[hit_index].time = packet->timestamp + XHPTDC8_PACKED_DELTA(word);
+        hit_buf[hit_index].channel = XHPTDC8_PACKED_CHANNEL(word);
+        hit_buf[hit_index].type = XHPTDC8_PACKED_TYPE(word);
+        hit_buf[hit_index].bin = XHPTDC8_PACKED_BIN(word);
+        hit_buf[hit_index].reserved = 0;
+    }
+    return static_cast<int>(hit_count);
+}
@@ -0,0 +1,204 @@
+#include "xhptdc8_util.h"
+#include "xHPTDC8_interface.h"
+#include "xhptdc8_util_simd.h"
+#include <cmath>
+#include <cstdint>
+
+// The bin size is applied as fixed point number with BINSIZE_SHIFT fractional bits, so bins * binsize is rounded
+// correctly using only integer instructions that exist in AVX2. The 128 bit product does not overflow, the result
+// is exact as long as it fits into int64_t, i.e. up to 2^63 / binsize bins, about 2^59.3 bins of 13 ps
+#define BINSIZE_SHIFT 58
+
+// round(x * factor / 2^BINSIZE_SHIFT) of the 128 bit product, built from 32 bit products like the SIMD versions
+static inline uint64_t mul_shift(uint64_t x, uint64_t factor) {
+    const uint64_t mask = 0xFFFFFFFF;
+    uint64_t p0 = (x & mask) * (factor & mask);
+    uint64_t p1 = (x & mask) * (factor >> 32);
+    uint64_t p2 = (x >> 32) * (factor & mask);
+    uint64_t p3 = (x >> 32) * (factor >> 32);
+    // Bits 32 to 63 of the product plus 1/2 of the result, carry in the upper bits
+    uint64_t mid = (p0 >> 32) + (p1 & mask) + (p2 & mask) + (1ull << (BINSIZE_SHIFT - 33));
+    uint64_t high = p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+    return (high << (64 - BINSIZE_SHIFT)) | ((mid >> (BINSIZE_SHIFT - 32)) & ((1ull << (64 - BINSIZE_SHIFT)) - 1));
+}
+
+static inline int64_t bin_to_ps(int64_t bin, uint64_t factor) {
+    // All ones for negative values, the magnitude is converted and the sign restored
+    uint64_t sign = 0 - static_cast<uint64_t>(bin < 0);
+    uint64_t magnitude = (static_cast<uint64_t>(bin) ^ sign) - sign;
+    return static_cast<int64_t>((mul_shift(magnitude, factor) ^ sign) - sign);
+}
+
+#ifdef SIMD_X86_64
+#if defined(__GNUC__) && !defined(__clang__)
+// The AVX-512 intrinsics of GCC 12 start from _mm512_undefined_epi32(), which is reported as uninitialized
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+SIMD_TARGET("avx2") static inline __m256i mul_shift_avx2(__m256i x, __m256i factor_low, __m256i factor_high) {
+    const __m256i mask = _mm256_set1_epi64x(0xFFFFFFFF);
+    __m256i x_high = _mm256_srli_epi64(x, 32);
+    __m256i p0 = _mm256_mul_epu32(x, factor_low);
+    __m256i p1 = _mm256_mul_epu32(x, factor_high);
+    __m256i p2 = _mm256_mul_epu32(x_high, factor_low);
+    __m256i p3 = _mm256_mul_epu32(x_high, factor_high);
+    __m256i mid = _mm256_add_epi64(_mm256_add_epi64(_mm256_srli_epi64(p0, 32), _mm256_and_si256(p1, mask)),
+                                   _mm256_add_epi64(_mm256_and_si256(p2, mask),
+                                                    _mm256_set1_epi64x(1ll << (BINSIZE_SHIFT - 33))));
+    __m256i high = _mm256_add_epi64(_mm256_add_epi64(p3, _mm256_srli_epi64(p1, 32)),
+                                    _mm256_add_epi64(_mm256_srli_epi64(p2, 32), _mm256_srli_epi64(mid, 32)));
+    return _mm256_or_si256(_mm256_slli_epi64(high, 64 - BINSIZE_SHIFT),
+                           _mm256_and_si256(_mm256_srli_epi64(mid, BINSIZE_SHIFT - 32),
+                                            _mm256_set1_epi64x((1ll << (64 - BINSIZE_SHIFT)) - 1)));
+}
+
+SIMD_TARGET("avx2") static inline __m256i bin_to_ps_avx2(__m256i bins, __m256i factor_low, __m256i factor_high) {
+    __m256i sign = _mm256_cmpgt_epi64(_mm256_setzero_si256(), bins);
+    __m256i magnitude = _mm256_sub_epi64(_mm256_xor_si256(bins, sign), sign);
+    __m256i ps = mul_shift_avx2(magnitude, factor_low, factor_high);
+    return _mm256_sub_epi64(_mm256_xor_si256(ps, sign), sign);
+}
+
+SIMD_TARGET("avx2")
+static size_t bins_to_ps_avx2(uint64_t factor, const int64_t *bins, int64_t *ps, size_t count) {
+    const __m256i factor_low = _mm256_set1_epi64x(static_cast<int64_t>(factor & 0xFFFFFFFF));
+    const __m256i factor_high = _mm256_set1_epi64x(static_cast<int64_t>(factor >> 32));
+    size_t index = 0;
+    for (; index + 4 <= count; index += 4) {
+        __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bins + index));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(ps + index),
+                            bin_to_ps_avx2(values, factor_low, factor_high));
+    }
+    return index;
+}
+
+SIMD_TARGET("avx2") static size_t hits_bins_to_ps_avx2(uint64_t factor, TDCHit *hits, size_t hit_count) {
+    const __m256i factor_low = _mm256_set1_epi64x(static_cast<int64_t>(factor & 0xFFFFFFFF));
+    const __m256i factor_high = _mm256_set1_epi64x(static_cast<int64_t>(factor >> 32));
+    size_t index = 0;
+    for (; index + 4 <= hit_count; index += 4) {
+        // Two hits per register, time is the lower quadword of each hit
+        __m256i *first = reinterpret_cast<__m256i *>(hits + index);
+        __m256i *second = reinterpret_cast<__m256i *>(hits + index + 2);
+        __m256i hits_01 = _mm256_loadu_si256(first);
+        __m256i hits_23 = _mm256_loadu_si256(second);
+        // Times of hits 0, 2, 1, 3
+        __m256i times = _mm256_unpacklo_epi64(hits_01, hits_23);
+        times = bin_to_ps_avx2(times, factor_low, factor_high);
+        _mm256_storeu_si256(first, _mm256_blend_epi32(hits_01, times, 0x33));
+        _mm256_storeu_si256(second, _mm256_blend_epi32(hits_23, _mm256_unpackhi_epi64(times, times), 0x33));
+    }
+    return index;
+}
+
+SIMD_TARGET("avx512f")
+static inline __m512i bin_to_ps_avx512(__m512i bins, __m512i factor_low, __m512i factor_high) {
+    const __m512i mask = _mm512_set1_epi64(0xFFFFFFFF);
+    __m512i sign = _mm512_srai_epi64(bins, 63);
+    __m512i x = _mm512_abs_epi64(bins);
+    __m512i x_high = _mm512_srli_epi64(x, 32);
+    __m512i p0 = _mm512_mul_epu32(x, factor_low);
+    __m512i p1 = _mm512_mul_epu32(x, factor_high);
+    __m512i p2 = _mm512_mul_epu32(x_high, factor_low);
+    __m512i p3 = _mm512_mul_epu32(x_high, factor_high);
+    __m512i mid = _mm512_add_epi64(_mm512_add_epi64(_mm512_srli_epi64(p0, 32), _mm512_and_si512(p1, mask)),
+                                   _mm512_add_epi64(_mm512_and_si512(p2, mask),
+                                                    _mm512_set1_epi64(1ll << (BINSIZE_SHIFT - 33))));
+    __m512i high = _mm512_add_epi64(_mm512_add_epi64(p3, _mm512_srli_epi64(p1, 32)),
+                                    _mm512_add_epi64(_mm512_srli_epi64(p2, 32), _mm512_srli_epi64(mid, 32)));
+    __m512i ps = _mm512_or_si512(_mm512_slli_epi64(high, 64 - BINSIZE_SHIFT),
+                                 _mm512_and_si512(_mm512_srli_epi64(mid, BINSIZE_SHIFT - 32),
+                                                  _mm512_set1_epi64((1ll << (64 - BINSIZE_SHIFT)) - 1)));
+    return _mm512_sub_epi64(_mm512_xor_si512(ps, sign), sign);
+}
+
+SIMD_TARGET("avx512f")
+static size_t bins_to_ps_avx512(uint64_t factor, const int64_t *bins, int64_t *ps, size_t count) {
+    const __m512i factor_low = _mm512_set1_epi64(static_cast<int64_t>(factor & 0xFFFFFFFF));
+    const __m512i factor_high = _mm512_set1_epi64(static_cast<int64_t>(factor >> 32));
+    size_t index = 0;
+    for (; index + 8 <= count; index += 8) {
+        __m512i values = _mm512_loadu_si512(bins + index);
+        _mm512_storeu_si512(ps + index, bin_to_ps_avx512(values, factor_low, factor_high));
+    }
+    return index;
+}
+
+SIMD_TARGET("avx512f") static size_t hits_bins_to_ps_avx512(uint64_t factor, TDCHit *hits, size_t hit_count) {
+    const __m512i factor_low = _mm512_set1_epi64(static_cast<int64_t>(factor & 0xFFFFFFFF));
+    const __m512i factor_high = _mm512_set1_epi64(static_cast<int64_t>(factor >> 32));
+    size_t index = 0;
+    for (; index + 8 <= hit_count; index += 8) {
+        // Four hits per register, time is the lower quadword of each hit
+        __m512i hits_0123 = _mm512_loadu_si512(hits + index);
+        __m512i hits_4567 = _mm512_loadu_si512(hits + index + 4);
+        // Times of hits 0, 4, 1, 5, 2, 6, 3, 7
+        __m512i times = _mm512_unpacklo_epi64(hits_0123, hits_4567);
+        times = bin_to_ps_avx512(times, factor_low, factor_high);
+        _mm512_storeu_si512(hits + index, _mm512_mask_blend_epi64(0x55, hits_0123, times));
+        _mm512_storeu_si512(hits + index + 4,
+                            _mm512_mask_blend_epi64(0x55, hits_4567, _mm512_unpackhi_epi64(times, times)));
+    }
+    return index;
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+// Fixed point bin size, 0 if binsize is invalid
+static uint64_t get_factor(double binsize) {
+    // The factor must fit into 62 bits, so the result of the largest bins fits into int64_t
+    if (!(binsize > 0 && binsize < 16)) {
+        return 0;
+    }
+    return static_cast<uint64_t>(std::llround(std::ldexp(binsize, BINSIZE_SHIFT)));
+}
+
+int xhptdc8_bins_to_ps(double binsize, const int64_t *bins, int64_t *ps, size_t count) {
+    uint64_t factor = get_factor(binsize);
+    if (0 == factor || ((nullptr == bins || nullptr == ps) && count > 0)) {
+        return XHPTDC8_INVALID_ARGUMENTS;
+    }
+    size_t index = 0;
+#ifdef SIMD_X86_64
+    switch (get_simd_level()) {
+    case SIMD_AVX512:
+        index = bins_to_ps_avx512(factor, bins, ps, count);
+        break;
+    case SIMD_AVX2:
+        index = bins_to_ps_avx2(factor, bins, ps, count);
+        break;
+    default:
+        break;
+    }
+#endif
+    for (; index < count; index++) {
+        ps[index] = bin_to_ps(bins[index], factor);
+    }
+    return XHPTDC8_OK;
+}
+
+int xhptdc8_hits_bins_to_ps(double binsize, TDCHit *hits, size_t hit_count) {
+    uint64_t factor = get_factor(binsize);
+    if (0 == factor || (nullptr == hits && hit_count > 0)) {
+        return XHPTDC8_INVALID_ARGUMENTS;
+    }
+    size_t index = 0;
+#ifdef SIMD_X86_64
+    switch (get_simd_level()) {
+    case SIMD_AVX512:
+        index = hits_bins_to_ps_avx512(factor, hits, hit_count);
+        break;
+    case SIMD_AVX2:
+        index = hits_bins_to_ps_avx2(factor, hits, hit_count);
+        break;
+    default:
+        break;
+    }
+#endif
+    for (; index < hit_count; index++) {
+        hits[index].time = bin_to_ps(hits[index].time, factor);
+    }
+    return XHPTDC8_OK;
+}
@@ -0,0 +1,224 @@
+#include "xhptdc8_util.h"
+#include "xHPTDC8_interface.h"
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+
+// Number of samples of the fit
+#define CLOCK_SAMPLE_COUNT 64
+// Calls of xhptdc8_get_current_timestamp() per sample
+#define CLOCK_SAMPLE_TRIES 5
+// Deviation in nanoseconds from the previous sample at which the board time is considered reset, e.g. by
+// xhptdc8_start_capture()
+#define CLOCK_RESET_THRESHOLD_NS 1000000
+
+struct clock_sample {
+    int64_t board_time;
+    // Middle of the steady_clock window around the call of xhptdc8_get_current_timestamp()
+    int64_t monotonic_time;
+    // system_clock - steady_clock
+    int64_t realtime_offset;
+};
+
+struct xhptdc8_clock_correlation_ {
+    int index;
+    int interval_ms;
+    std::thread thread;
+    bool stop;
+    std::condition_variable stop_condition;
+
+    // Guards stop and the members below
+    std::mutex mutex;
+    xhptdc8_clock_fit fit;
+    int64_t realtime_offset;
+
+    // Used by the sampling thread only
+    clock_sample samples[CLOCK_SAMPLE_COUNT];
+    int sample_count;
+    int next_sample;
+};
+
+static int64_t steady_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static int64_t system_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+// Takes the sample with the shortest host time window, it is least disturbed by interrupts and bus traffic
+static bool take_sample(int index, clock_sample *sample) {
+    int64_t best_window = -1;
+    for (int try_index = 0; try_index < CLOCK_SAMPLE_TRIES; try_index++) {
+        int64_t board_time;
+        int64_t before = steady_ns();
+        if (XHPTDC8_OK != xhptdc8_get_current_timestamp(index, &board_time)) {
+            return false;
+        }
+        int64_t after = steady_ns();
+        if (best_window < 0 || after - before < best_window) {
+            best_window = after - before;
+            sample->board_time = board_time;
+            sample->monotonic_time = before + (after - before) / 2;
+            sample->realtime_offset = system_ns() - after;
+        }
+    }
+    return true;
+}
+
+// Least squares fit relative to the newest sample, so the doubles keep the precision
+static void fit_samples(const xhptdc8_clock_correlation *correlation, xhptdc8_clock_fit *fit) {
+    int newest = (correlation->next_sample + CLOCK_SAMPLE_COUNT - 1) % CLOCK_SAMPLE_COUNT;
+    const clock_sample *reference = &correlation->samples[newest];
+    int count = correlation->sample_count;
+
+    double mean_x = 0;
+    double mean_y = 0;
+    for (int sample_index = 0; sample_index < count; sample_index++) {
+        mean_x += static_cast<double>(correlation->samples[sample_index].board_time - reference->board_time);
+        mean_y += static_cast<double>(correlation->samples[sample_index].monotonic_time - reference->monotonic_time);
+    }
+    mean_x /= count;
+    mean_y /= count;
+    double sum_xx = 0;
+    double sum_xy = 0;
+    for (int sample_index = 0; sample_index < count; sample_index++) {
+        double x = static_cast<double>(correlation->samples[sample_index].board_time - reference->board_time) - mean_x;
+        double y = static_cast<double>(correlation->samples[sample_index].monotonic_time - reference->monotonic_time) -
+                   mean_y;
+        sum_xx += x * x;
+        sum_xy += x * y;
+    }
+    double slope = (sum_xx > 0) ? sum_xy / sum_xx : 0.001;
+    double intercept = mean_y - slope * mean_x;
+    double sum_residuals = 0;
+    for (int sample_index = 0; sample_index < count; sample_index++) {
+        double x = static_cast<double>(correlation->samples[sample_index].board_time - reference->board_time);
+        double y = static_cast<double>(correlation->samples[sample_index].monotonic_time - reference->monotonic_time);
+        double residual = y - (intercept + slope * x);
+        sum_residuals += residual * residual;
+    }
+
+    fit->board_time = reference->board_time;
+    fit->host_time = reference->monotonic_time + std::llround(intercept);
+    fit->slope = slope;
+    fit->drift_ppm = (slope > 0) ? (0.001 / slope - 1) * 1e6 : 0;
+    fit->residual_ns = std::sqrt(sum_residuals / count);
+    fit->sample_count = count;
+}
+
+static void clock_correlation_loop(xhptdc8_clock_correlation *correlation) {
+    std::unique_lock<std::mutex> lock(correlation->mutex);
+    while (!correlation->stop) {
+        lock.unlock();
+        clock_sample sample;
+        if (take_sample(correlation->index, &sample)) {
+            if (correlation->sample_count > 0) {
+                int previous = (correlation->next_sample + CLOCK_SAMPLE_COUNT - 1) % CLOCK_SAMPLE_COUNT;
+                int64_t host_elapsed = sample.monotonic_time - correlation->samples[previous].monotonic_time;
+                int64_t board_elapsed = (sample.board_time - correlation->samples[previous].board_time) / 1000;
+                int64_t deviation = host_elapsed - board_elapsed;
+                if (deviation > CLOCK_RESET_THRESHOLD_NS || deviation < -CLOCK_RESET_THRESHOLD_NS) {
+                    // The samples before the reset do not belong to the current board time
+                    correlation->sample_count = 0;
+                    correlation->next_sample = 0;
+                }
+            }
+            correlation->samples[correlation->next_sample] = sample;
+            correlation->next_sample = (correlation->next_sample + 1) % CLOCK_SAMPLE_COUNT;
+            if (correlation->sample_count < CLOCK_SAMPLE_COUNT) {
+                correlation->sample_count++;
+            }
+        }
+        xhptdc8_clock_fit fit;
+        int64_t realtime_offset = 0;
+        bool has_fit = correlation->sample_count >= 2;
+        if (has_fit) {
+            fit_samples(correlation, &fit);
+            int newest = (correlation->next_sample + CLOCK_SAMPLE_COUNT - 1) % CLOCK_SAMPLE_COUNT;
+            realtime_offset = correlation->samples[newest].realtime_offset;
+        }
+        lock.lock();
+        if (has_fit) {
+            correlation->fit = fit;
+            correlation->realtime_offset = realtime_offset;
+        } else {
+            correlation->fit.sample_count = 0;
+        }
+        correlation->stop_condition.wait_for(lock, std::chrono::milliseconds(correlation->interval_ms),
+                                             [correlation] { return correlation->stop; });
+    }
+}
+
+xhptdc8_clock_correlation *xhptdc8_start_clock_correlation(int index, int interval_ms) {
+    if (index < 0 || index >= XHPTDC8_MANAGER_DEVICES_MAX || interval_ms < 1) {
+        return nullptr;
+    }
+    xhptdc8_clock_correlation *correlation = new (std::nothrow) xhptdc8_clock_correlation;
+    if (nullptr == correlation) {
+        return nullptr;
+    }
+    correlation->index = index;
+    correlation->interval_ms = interval_ms;
+    correlation->stop = false;
+    correlation->fit = xhptdc8_clock_fit();
+    correlation->realtime_offset = 0;
+    correlation->sample_count = 0;
+    correlation->next_sample = 0;
+    try {
+        correlation->thread = std::thread(clock_correlation_loop, correlation);
+    } catch (const std::system_error &) {
+        delete correlation;
+        return nullptr;
+    }
+    return correlation;
+}
+
+int xhptdc8_stop_clock_correlation(xhptdc8_clock_correlation *correlation) {
+    if (nullptr == correlation) {
+        return XHPTDC8_INVALID_ARGUMENTS;
+    }
+    {
+        std::lock_guard<std::mutex> lock(correlation->mutex);
+        correlation->stop = true;
+    }
+    correlation->stop_condition.notify_one();
+    correlation->thread.join();
+    delete correlation;
+    return XHPTDC8_OK;
+}
+
+int xhptdc8_get_clock_fit(xhptdc8_clock_correlation *correlation, int host_clock, xhptdc8_clock_fit *fit) {
+    if (nullptr == correlation || nullptr == fit ||
+        (XHPTDC8_HOST_CLOCK_MONOTONIC != host_clock && XHPTDC8_HOST_CLOCK_REALTIME != host_clock)) {
+        return XHPTDC8_INVALID_ARGUMENTS;
+    }
+    std::lock_guard<std::mutex> lock(correlation->mutex);
+    if (correlation->fit.sample_count < 2) {
+        return XHPTDC8_INSUFFICIENT_DATA;
+    }
+    *fit = correlation->fit;
+    if (XHPTDC8_HOST_CLOCK_REALTIME == host_clock) {
+        fit->host_time += correlation->realtime_offset;
+    }
+    return XHPTDC8_OK;
+}
+
+void xhptdc8_board_to_host_ns(const xhptdc8_clock_fit *fit, const int64_t *board_times, int64_t *host_times,
+                              size_t count) {
+    const int64_t board_time = fit->board_time;
+    const int64_t host_time = fit->host_time;
+    const double slope = fit->slope;
+    for (size_t index = 0; index < count; index++) {
+        host_times[index] =
+            host_time + static_cast<int64_t>(static_cast<double>(board_times[index] - board_time) * slope);
+    }
+}
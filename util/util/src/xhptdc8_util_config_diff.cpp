@@ -0,0 +1,168 @@
+#include "xhptdc8_util.h"
+#include "xHPTDC8_interface.h"
+#include <new>
+
+// The structures have padding between fields of different size, so they are compared field by field instead of
+// with memcmp()
+
+static bool equal_tiger_block(const xhptdc8_tiger_block &a, const xhptdc8_tiger_block &b) {
+    return a.mode == b.mode && a.negate == b.negate && a.retrigger == b.retrigger && a.extend == b.extend &&
+           a.start == b.start && a.stop == b.stop && a.sources == b.sources;
+}
+
+static int compare_device(const xhptdc8_device_configuration &a, const xhptdc8_device_configuration &b) {
+    int blocks = 0;
+    if (a.auto_trigger_period != b.auto_trigger_period ||
+        a.auto_trigger_random_exponent != b.auto_trigger_random_exponent) {
+        blocks |= XHPTDC8_CONFIG_BLOCK_AUTO_TRIGGER;
+    }
+    for (int index = 0; index < XHPTDC8_TDC_CHANNEL_COUNT; index++) {
+        if (a.trigger_threshold[index] != b.trigger_threshold[index]) {
+            blocks |= XHPTDC8_CONFIG_BLOCK_THRESHOLD;
+        }
+        if (a.channel[index].enable != b.channel[index].enable || a.channel[index].rising != b.channel[index].rising) {
+            blocks |= XHPTDC8_CONFIG_BLOCK_CHANNEL;
+        }
+    }
+    for (int index = 0; index < XHPTDC8_TRIGGER_COUNT; index++) {
+        if (a.trigger[index].falling != b.trigger[index].falling ||
+            a.trigger[index].rising != b.trigger[index].rising) {
+            blocks |= XHPTDC8_CONFIG_BLOCK_TRIGGER;
+        }
+    }
+    for (int index = 0; index < XHPTDC8_GATE_COUNT; index++) {
+        if (!equal_tiger_block(a.gating_block[index], b.gating_block[index])) {
+            blocks |= XHPTDC8_CONFIG_BLOCK_GATING;
+        }
+    }
+    for (int index = 0; index < XHPTDC8_TIGER_COUNT; index++) {
+        if (!equal_tiger_block(a.tiger_block[index], b.tiger_block[index])) {
+            blocks |= XHPTDC8_CONFIG_BLOCK_TIGER;
+        }
+    }
+    if (a.adc_channel.enable != b.adc_channel.enable ||
+        a.adc_channel.watchdog_readout != b.adc_channel.watchdog_readout ||
+        a.adc_channel.watchdog_interval != b.adc_channel.watchdog_interval ||
+        a.adc_channel.trigger_threshold != b.adc_channel.trigger_threshold) {
+        blocks |= XHPTDC8_CONFIG_BLOCK_ADC;
+    }
+    if (a.alignment_source != b.alignment_source || a.alignment_off_state != b.alignment_off_state) {
+        blocks |= XHPTDC8_CONFIG_BLOCK_ALIGNMENT;
+    }
+    return blocks;
+}
+
+static bool equal_grouping(const xhptdc8_grouping_configuration &a, const xhptdc8_grouping_configuration &b) {
+    return a.enabled == b.enabled && a.trigger_channel == b.trigger_channel &&
+           a.trigger_channel_bitmask == b.trigger_channel_bitmask && a.range_start == b.range_start &&
+           a.range_stop == b.range_stop && a.trigger_deadtime == b.trigger_deadtime &&
+           a.zero_channel == b.zero_channel && a.zero_channel_offset == b.zero_channel_offset &&
+           a.window_hit_channels == b.window_hit_channels && a.window_start == b.window_start &&
+           a.window_stop == b.window_stop && a.veto_mode == b.veto_mode && a.veto_start == b.veto_start &&
+           a.veto_stop == b.veto_stop && a.veto_active_channels == b.veto_active_channels &&
+           a.veto_relative_to_zero == b.veto_relative_to_zero && a.ignore_empty_events == b.ignore_empty_events &&
+           a.overlap == b.overlap;
+}
+
+int xhptdc8_compare_configuration(const xhptdc8_manager_configuration *current,
+                                  const xhptdc8_manager_configuration *mgr_cfg, xhptdc8_config_changes *changes) {
+    if (nullptr == current || nullptr == mgr_cfg || nullptr == changes) {
+        return XHPTDC8_INVALID_ARGUMENTS;
+    }
+    for (int device_index = 0; device_index < XHPTDC8_MANAGER_DEVICES_MAX; device_index++) {
+        changes->device_blocks[device_index] =
+            compare_device(current->device_configs[device_index], mgr_cfg->device_configs[device_index]);
+    }
+    changes->manager_blocks = 0;
+    if (!equal_grouping(current->grouping, mgr_cfg->grouping)) {
+        changes->manager_blocks |= XHPTDC8_CONFIG_MANAGER_GROUPING;
+    }
+    // Drivers of older configuration versions do not report the later members
+    if (current->version >= 2 && current->time_unit != mgr_cfg->time_unit) {
+        changes->manager_blocks |= XHPTDC8_CONFIG_MANAGER_TIME_UNIT;
+    }
+    for (int channel = 0; current->version >= 3 && channel < XHPTDC8_CHANNEL_OFFSET_COUNT; channel++) {
+        if (current->channel_offset[channel] != mgr_cfg->channel_offset[channel]) {
+            changes->manager_blocks |= XHPTDC8_CONFIG_MANAGER_CHANNEL_OFFSET;
+        }
+    }
+    changes->configured = false;
+    changes->aligned_devices = 0;
+    return XHPTDC8_OK;
+}
+
+int xhptdc8_configure_changes(const xhptdc8_manager_configuration *mgr_cfg, xhptdc8_config_changes *changes) {
+    if (nullptr == mgr_cfg) {
+        return XHPTDC8_INVALID_ARGUMENTS;
+    }
+    xhptdc8_config_changes local_changes;
+    if (nullptr == changes) {
+        changes = &local_changes;
+    }
+    xhptdc8_fast_info fast_info;
+    int error_code = xhptdc8_get_fast_info(0, &fast_info);
+    if (XHPTDC8_OK != error_code) {
+        return error_code;
+    }
+    // The configuration is copied, as the driver takes a non-const pointer and skip_alignment may be changed
+    xhptdc8_manager_configuration *new_cfg = new (std::nothrow) xhptdc8_manager_configuration;
+    xhptdc8_manager_configuration *current = new (std::nothrow) xhptdc8_manager_configuration();
+    if (nullptr == new_cfg || nullptr == current) {
+        delete new_cfg;
+        delete current;
+        return XHPTDC8_BUFFER_ALLOC_FAILED;
+    }
+    *new_cfg = *mgr_cfg;
+    bool first_configuration = (XHPTDC8_DEVICE_STATE_INITIALIZED == fast_info.state);
+    if (first_configuration) {
+        for (int device_index = 0; device_index < XHPTDC8_MANAGER_DEVICES_MAX; device_index++) {
+            changes->device_blocks[device_index] = XHPTDC8_CONFIG_BLOCKS_ALL;
+        }
+        changes->manager_blocks = XHPTDC8_CONFIG_MANAGER_GROUPING | XHPTDC8_CONFIG_MANAGER_TIME_UNIT |
+                                  XHPTDC8_CONFIG_MANAGER_CHANNEL_OFFSET;
+        changes->configured = false;
+        changes->aligned_devices = 0;
+    } else {
+        error_code = xhptdc8_get_current_configuration(current);
+        if (XHPTDC8_OK == error_code) {
+            xhptdc8_compare_configuration(current, mgr_cfg, changes);
+        }
+        if (XHPTDC8_OK != error_code) {
+            delete new_cfg;
+            delete current;
+            return error_code;
+        }
+        bool changed = (0 != changes->manager_blocks);
+        for (int device_index = 0; device_index < XHPTDC8_MANAGER_DEVICES_MAX; device_index++) {
+            changed |= (0 != changes->device_blocks[device_index]);
+        }
+        if (!changed) {
+            delete new_cfg;
+            delete current;
+            return XHPTDC8_OK;
+        }
+        for (int device_index = 0; device_index < XHPTDC8_MANAGER_DEVICES_MAX; device_index++) {
+            if (0 == (changes->device_blocks[device_index] & XHPTDC8_CONFIG_BLOCKS_TIMING)) {
+                new_cfg->device_configs[device_index].skip_alignment = true;
+            }
+        }
+    }
+
+    delete current;
+    error_code = xhptdc8_configure(new_cfg);
+    if (XHPTDC8_OK == error_code) {
+        changes->configured = true;
+        // Only installed boards are aligned
+        int count_error_code;
+        const char *count_error_message;
+        int device_count = xhptdc8_count_devices(&count_error_code, &count_error_message);
+        for (int device_index = 0; device_index < device_count && device_index < XHPTDC8_MANAGER_DEVICES_MAX;
+             device_index++) {
+            if (!new_cfg->device_configs[device_index].skip_alignment) {
+                changes->aligned_devices |= 1 << device_index;
+            }
+        }
+    }
+    delete new_cfg;
+    return error_code;
+}
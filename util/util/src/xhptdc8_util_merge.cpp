@@ -0,0 +1,167 @@
+#include "xhptdc8_util.h"
+#include "xHPTDC8_interface.h"
+#include <climits>
+#include <new>
+#include <vector>
+
+// Number of leaves of the loser tree, a power of 2 >= XHPTDC8_MANAGER_DEVICES_MAX
+#define MERGER_LEAF_COUNT 8
+
+struct merger_stream {
+    std::vector<TDCHit> hits;
+    // Index of the next hit to merge
+    size_t read_index;
+    // Time of the last pushed hit
+    int64_t last_time;
+};
+
+struct xhptdc8_merger_ {
+    int board_count;
+    int64_t latency;
+    merger_stream streams[MERGER_LEAF_COUNT];
+
+    // Time of the next hit of each leaf. For a stream without hits, the time up to which no hits can follow.
+    int64_t key[MERGER_LEAF_COUNT];
+    // Set if the leaf has no hits, hits up to its key are merged but not beyond
+    bool sentinel[MERGER_LEAF_COUNT];
+    // Loser of each inner node, the overall winner at index 0
+    int tree[MERGER_LEAF_COUNT];
+};
+
+// Leaf a precedes leaf b. Equal times are taken from the lower board first, a sentinel loses ties.
+static inline bool leaf_less(const xhptdc8_merger *merger, int a, int b) {
+    int64_t key_a = merger->key[a];
+    int64_t key_b = merger->key[b];
+    if (key_a != key_b) {
+        return key_a < key_b;
+    }
+    if (merger->sentinel[a] != merger->sentinel[b]) {
+        return merger->sentinel[b];
+    }
+    return a < b;
+}
+
+static void set_leaf(xhptdc8_merger *merger, int leaf, int64_t empty_bound) {
+    merger_stream *stream = &merger->streams[leaf];
+    if (leaf < merger->board_count && stream->read_index < stream->hits.size()) {
+        merger->key[leaf] = stream->hits[stream->read_index].time;
+        merger->sentinel[leaf] = false;
+    } else {
+        // Hits pushed later are neither older than the last pushed hit of the stream nor than empty_bound
+        int64_t bound = (leaf < merger->board_count) ? stream->last_time : LLONG_MAX;
+        merger->key[leaf] = (empty_bound > bound) ? empty_bound : bound;
+        merger->sentinel[leaf] = true;
+    }
+}
+
+static void build_tree(xhptdc8_merger *merger) {
+    int winner[2 * MERGER_LEAF_COUNT];
+    for (int leaf = 0; leaf < MERGER_LEAF_COUNT; leaf++) {
+        winner[MERGER_LEAF_COUNT + leaf] = leaf;
+    }
+    for (int node = MERGER_LEAF_COUNT - 1; node >= 1; node--) {
+        int left = winner[2 * node];
+        int right = winner[2 * node + 1];
+        bool left_wins = leaf_less(merger, left, right);
+        winner[node] = left_wins ? left : right;
+        merger->tree[node] = left_wins ? right : left;
+    }
+    merger->tree[0] = winner[1];
+}
+
+// Replays the matches from leaf to the root after the key of leaf changed
+static inline void replay(xhptdc8_merger *merger, int leaf) {
+    int winner = leaf;
+    for (int node = (leaf + MERGER_LEAF_COUNT) / 2; node >= 1; node /= 2) {
+        int loser = merger->tree[node];
+        if (leaf_less(merger, loser, winner)) {
+            merger->tree[node] = winner;
+            winner = loser;
+        }
+    }
+    merger->tree[0] = winner;
+}
+
+xhptdc8_merger *xhptdc8_create_merger(int board_count, int64_t latency) {
+    if (board_count < 1 || board_count > XHPTDC8_MANAGER_DEVICES_MAX || latency < 0) {
+        return nullptr;
+    }
+    xhptdc8_merger *merger = new (std::nothrow) xhptdc8_merger;
+    if (nullptr == merger) {
+        return nullptr;
+    }
+    merger->board_count = board_count;
+    merger->latency = latency;
+    for (merger_stream &stream : merger->streams) {
+        stream.read_index = 0;
+        stream.last_time = LLONG_MIN;
+    }
+    return merger;
+}
+
+void xhptdc8_destroy_merger(xhptdc8_merger *merger) { delete merger; }
+
+int xhptdc8_merger_push(xhptdc8_merger *merger, const TDCHit *hits, size_t hit_count) {
+    if (nullptr == merger || (nullptr == hits && hit_count > 0)) {
+        return XHPTDC8_INVALID_ARGUMENTS;
+    }
+    int pushed_count = 0;
+    for (size_t hit_index = 0; hit_index < hit_count; hit_index++) {
+        int board = hits[hit_index].channel / XHPTDC8_NOF_CHANNELS_PER_CARD;
+        if (board >= merger->board_count) {
+            continue;
+        }
+        merger_stream *stream = &merger->streams[board];
+        try {
+            stream->hits.push_back(hits[hit_index]);
+        } catch (const std::bad_alloc &) {
+            break;
+        }
+        stream->last_time = hits[hit_index].time;
+        pushed_count++;
+    }
+    return pushed_count;
+}
+
+int xhptdc8_merger_pop(xhptdc8_merger *merger, TDCHit *hit_buf, size_t max_hits, crono_bool_t flush) {
+    if (nullptr == merger || (nullptr == hit_buf && max_hits > 0)) {
+        return XHPTDC8_INVALID_ARGUMENTS;
+    }
+
+    int64_t empty_bound = LLONG_MAX;
+    if (!flush) {
+        int64_t newest_time = LLONG_MIN;
+        for (int board = 0; board < merger->board_count; board++) {
+            if (merger->streams[board].last_time > newest_time) {
+                newest_time = merger->streams[board].last_time;
+            }
+        }
+        empty_bound = (newest_time < LLONG_MIN + merger->latency) ? LLONG_MIN : newest_time - merger->latency;
+    }
+    for (int leaf = 0; leaf < MERGER_LEAF_COUNT; leaf++) {
+        set_leaf(merger, leaf, empty_bound);
+    }
+    build_tree(merger);
+
+    size_t hit_count = 0;
+    while (hit_count < max_hits) {
+        int winner = merger->tree[0];
+        if (merger->sentinel[winner]) {
+            break;
+        }
+        merger_stream *stream = &merger->streams[winner];
+        hit_buf[hit_count++] = stream->hits[stream->read_index++];
+        set_leaf(merger, winner, empty_bound);
+        replay(merger, winner);
+    }
+
+    // Drop the merged hits, at most half of a stream is kept unused
+    for (int board = 0; board < merger->board_count; board++) {
+        merger_stream *stream = &merger->streams[board];
+        if (stream->read_index > 0 && 2 * stream->read_index >= stream->hits.size()) {
+            stream->hits.erase(stream->hits.begin(), stream->hits.begin() + stream->read_index);
+            stream->read_index = 0;
+        }
+    }
+    return static_cast<int>(hit_count);
+}
@@ -0,0 +1,162 @@
+#include "xhptdc8_util.h"
+#include "xHPTDC8_interface.h"
+#include "xhptdc8_util_simd.h"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+
+// Entries of the offset table, the channel is clamped to the last entry, so the gather stays inside the table for
+// every TDCHit::channel. Entries from XHPTDC8_CHANNEL_OFFSET_COUNT on are 0.
+#define OFFSET_TABLE_SIZE 64
+
+// Average number of hits a hit may pass in the insertion sort before std::stable_sort is used
+#define INSERTION_SORT_MAX_MOVES 16
+
+static inline unsigned table_index(uint8_t channel) {
+    return (channel < OFFSET_TABLE_SIZE - 1) ? channel : OFFSET_TABLE_SIZE - 1;
+}
+
+#ifdef SIMD_X86_64
+#if defined(__GNUC__) && !defined(__clang__)
+// The AVX-512 intrinsics of GCC 12 start from _mm512_undefined_epi32(), which is reported as uninitialized
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+// Returns the number of hits processed, *disorder is set if a time is less than the time of the hit before
+SIMD_TARGET("avx2")
+static size_t apply_offsets_avx2(const int64_t *table, TDCHit *hits, size_t hit_count, bool *disorder) {
+    const __m256i channel_mask = _mm256_set1_epi64x(0xFF);
+    const __m256i last_entry = _mm256_set1_epi64x(OFFSET_TABLE_SIZE - 1);
+    __m256i previous = _mm256_set1_epi64x(LLONG_MIN);
+    __m256i descending = _mm256_setzero_si256();
+    size_t index = 0;
+    for (; index + 4 <= hit_count; index += 4) {
+        // Two hits per register, time is the lower quadword of each hit, channel the lowest byte of the upper one
+        __m256i *first = reinterpret_cast<__m256i *>(hits + index);
+        __m256i *second = reinterpret_cast<__m256i *>(hits + index + 2);
+        __m256i hits_01 = _mm256_loadu_si256(first);
+        __m256i hits_23 = _mm256_loadu_si256(second);
+        // Lanes of hits 0, 2, 1, 3
+        __m256i channels = _mm256_and_si256(_mm256_unpackhi_epi64(hits_01, hits_23), channel_mask);
+        channels = _mm256_min_epu32(channels, last_entry);
+        __m256i offsets = _mm256_i64gather_epi64(reinterpret_cast<const long long *>(table), channels, 8);
+        __m256i times = _mm256_add_epi64(_mm256_unpacklo_epi64(hits_01, hits_23), offsets);
+        _mm256_storeu_si256(first, _mm256_blend_epi32(hits_01, times, 0x33));
+        _mm256_storeu_si256(second, _mm256_blend_epi32(hits_23, _mm256_unpackhi_epi64(times, times), 0x33));
+
+        // Compare the times in hit order with the times shifted by one hit
+        __m256i ordered = _mm256_permute4x64_epi64(times, 0xD8);
+        __m256i before = _mm256_blend_epi32(_mm256_permute4x64_epi64(ordered, 0x90),
+                                            _mm256_permute4x64_epi64(previous, 0xFF), 0x03);
+        descending = _mm256_or_si256(descending, _mm256_cmpgt_epi64(before, ordered));
+        previous = ordered;
+    }
+    if (!_mm256_testz_si256(descending, descending)) {
+        *disorder = true;
+    }
+    return index;
+}
+
+SIMD_TARGET("avx512f")
+static size_t apply_offsets_avx512(const int64_t *table, TDCHit *hits, size_t hit_count, bool *disorder) {
+    const __m512i channel_mask = _mm512_set1_epi64(0xFF);
+    const __m512i last_entry = _mm512_set1_epi64(OFFSET_TABLE_SIZE - 1);
+    // Hit order of the lanes of hits 0, 4, 1, 5, 2, 6, 3, 7
+    const __m512i order = _mm512_set_epi64(7, 5, 3, 1, 6, 4, 2, 0);
+    // Last lane of the previous block followed by lanes 0 to 6
+    const __m512i shift = _mm512_set_epi64(6, 5, 4, 3, 2, 1, 0, 15);
+    __m512i previous = _mm512_set1_epi64(LLONG_MIN);
+    __mmask8 descending = 0;
+    size_t index = 0;
+    for (; index + 8 <= hit_count; index += 8) {
+        // Four hits per register, time is the lower quadword of each hit, channel the lowest byte of the upper one
+        __m512i hits_0123 = _mm512_loadu_si512(hits + index);
+        __m512i hits_4567 = _mm512_loadu_si512(hits + index + 4);
+        __m512i channels = _mm512_and_si512(_mm512_unpackhi_epi64(hits_0123, hits_4567), channel_mask);
+        channels = _mm512_min_epu64(channels, last_entry);
+        __m512i offsets = _mm512_i64gather_epi64(channels, table, 8);
+        __m512i times = _mm512_add_epi64(_mm512_unpacklo_epi64(hits_0123, hits_4567), offsets);
+        _mm512_storeu_si512(hits + index, _mm512_mask_blend_epi64(0x55, hits_0123, times));
+        _mm512_storeu_si512(hits + index + 4,
+                            _mm512_mask_blend_epi64(0x55, hits_4567, _mm512_unpackhi_epi64(times, times)));
+
+        __m512i ordered = _mm512_permutexvar_epi64(order, times);
+        __m512i before = _mm512_permutex2var_epi64(ordered, shift, previous);
+        descending |= _mm512_cmpgt_epi64_mask(before, ordered);
+        previous = ordered;
+    }
+    if (descending) {
+        *disorder = true;
+    }
+    return index;
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+// A hit moves at most by the spread of the offsets, so only few hits are passed by the insertion sort. Hits
+// moving further fall back to std::stable_sort. Both keep the order of equal times.
+static void sort_hits(TDCHit *hits, size_t hit_count) {
+    size_t moves = 0;
+    for (size_t index = 1; index < hit_count; index++) {
+        if (hits[index].time >= hits[index - 1].time) {
+            continue;
+        }
+        TDCHit hit = hits[index];
+        size_t position = index;
+        for (; position > 0 && hits[position - 1].time > hit.time; position--) {
+            hits[position] = hits[position - 1];
+        }
+        hits[position] = hit;
+        moves += index - position;
+        if (moves > INSERTION_SORT_MAX_MOVES * hit_count) {
+            std::stable_sort(hits, hits + hit_count, [](const TDCHit &a, const TDCHit &b) { return a.time < b.time; });
+            return;
+        }
+    }
+}
+
+int xhptdc8_apply_channel_offsets(const xhptdc8_manager_configuration *mgr_cfg, int reference_channel, TDCHit *hits,
+                                  size_t hit_count) {
+    if (nullptr == mgr_cfg || (nullptr == hits && hit_count > 0) || reference_channel < -1 ||
+        reference_channel >= XHPTDC8_CHANNEL_OFFSET_COUNT) {
+        return XHPTDC8_INVALID_ARGUMENTS;
+    }
+    // Times relative to the reference channel are corrected by the difference of the offsets
+    int64_t reference_offset = (reference_channel >= 0) ? mgr_cfg->channel_offset[reference_channel] : 0;
+    int64_t table[OFFSET_TABLE_SIZE];
+    for (int channel = 0; channel < OFFSET_TABLE_SIZE; channel++) {
+        table[channel] =
+            (channel < XHPTDC8_CHANNEL_OFFSET_COUNT) ? mgr_cfg->channel_offset[channel] - reference_offset : 0;
+    }
+
+    bool disorder = false;
+    size_t index = 0;
+#ifdef SIMD_X86_64
+    switch (get_simd_level()) {
+    case SIMD_AVX512:
+        index = apply_offsets_avx512(table, hits, hit_count, &disorder);
+        break;
+    case SIMD_AVX2:
+        index = apply_offsets_avx2(table, hits, hit_count, &disorder);
+        break;
+    default:
+        break;
+    }
+#endif
+    int64_t previous = (index > 0) ? hits[index - 1].time : LLONG_MIN;
+    for (; index < hit_count; index++) {
+        int64_t time = hits[index].time + table[table_index(hits[index].channel)];
+        hits[index].time = time;
+        disorder |= time < previous;
+        previous = time;
+    }
+
+    // Most batches keep their order, as the offsets are small compared to the time between the hits
+    if (!disorder) {
+        return 0;
+    }
+    sort_hits(hits, hit_count);
+    return 1;
+}
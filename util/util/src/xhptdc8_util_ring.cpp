@@ -0,0 +1,388 @@
+#include "xhptdc8_util.h"
+#include "xHPTDC8_interface.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <system_error>
+#include <thread>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Drivers without xhptdc8_wait_for_hits() leave it unresolved
+#if !defined(_WIN32)
+#pragma weak xhptdc8_wait_for_hits
+#endif
+
+// Positions of producers and consumers are kept in separate cache lines, so they do not invalidate each other
+#define CACHE_LINE_SIZE 64
+
+struct hit_ring_slot {
+    // Sequence number of the bounded MPMC queue by Dmitry Vyukov
+    // MPMC: position + 1 when committed, position + slot count when released
+    std::atomic<uint64_t> sequence;
+    // Position of the slot while it is claimed or acquired
+    uint64_t position;
+    size_t hit_count;
+};
+
+struct xhptdc8_hit_ring_ {
+    int mode;
+    size_t slot_count; // A power of 2
+    size_t batch_hits;
+    hit_ring_slot *slots;
+    TDCHit *hits;
+    void *memory;
+
+    // Producer side
+    char producer_padding[CACHE_LINE_SIZE];
+    std::atomic<uint64_t> write_position;
+    // SPSC: read_position as last seen by the producer
+    uint64_t cached_read_position;
+
+    // Consumer side
+    char consumer_padding[CACHE_LINE_SIZE];
+    std::atomic<uint64_t> read_position;
+    // SPSC: write_position as last seen by the consumer
+    uint64_t cached_write_position;
+
+    char end_padding[CACHE_LINE_SIZE];
+};
+
+static size_t get_slot_index(xhptdc8_hit_ring *ring, const TDCHit *batch) {
+    if (nullptr == batch || batch < ring->hits) {
+        return ring->slot_count;
+    }
+    size_t offset = static_cast<size_t>(batch - ring->hits);
+    if (0 != offset % ring->batch_hits) {
+        return ring->slot_count;
+    }
+    return offset / ring->batch_hits;
+}
+
+xhptdc8_hit_ring *xhptdc8_create_hit_ring(int mode, size_t batch_count, size_t batch_hits) {
+    if ((XHPTDC8_HIT_RING_SPSC != mode && XHPTDC8_HIT_RING_MPMC != mode) || 0 == batch_count || 0 == batch_hits) {
+        return nullptr;
+    }
+    size_t slot_count = 1;
+    while (slot_count < batch_count) {
+        slot_count <<= 1;
+    }
+
+    // Batches start at cache line boundaries
+    size_t hits_bytes = slot_count * batch_hits * sizeof(TDCHit) + CACHE_LINE_SIZE;
+    xhptdc8_hit_ring *ring = new (std::nothrow) xhptdc8_hit_ring;
+    hit_ring_slot *slots = new (std::nothrow) hit_ring_slot[slot_count];
+    void *memory = ::operator new(hits_bytes, std::nothrow);
+    if (nullptr == ring || nullptr == slots || nullptr == memory) {
+        delete ring;
+        delete[] slots;
+        ::operator delete(memory);
+        return nullptr;
+    }
+
+    ring->mode = mode;
+    ring->slot_count = slot_count;
+    ring->batch_hits = batch_hits;
+    ring->slots = slots;
+    ring->memory = memory;
+    uintptr_t address = reinterpret_cast<uintptr_t>(memory);
+    ring->hits = reinterpret_cast<TDCHit *>((address + CACHE_LINE_SIZE - 1) & ~uintptr_t(CACHE_LINE_SIZE - 1));
+    for (size_t slot_index = 0; slot_index < slot_count; slot_index++) {
+        slots[slot_index].sequence.store(slot_index, std::memory_order_relaxed);
+        slots[slot_index].position = 0;
+        slots[slot_index].hit_count = 0;
+    }
+    ring->write_position.store(0, std::memory_order_relaxed);
+    ring->cached_read_position = 0;
+    ring->read_position.store(0, std::memory_order_relaxed);
+    ring->cached_write_position = 0;
+    return ring;
+}
+
+void xhptdc8_destroy_hit_ring(xhptdc8_hit_ring *ring) {
+    if (nullptr == ring) {
+        return;
+    }
+    delete[] ring->slots;
+    ::operator delete(ring->memory);
+    delete ring;
+}
+
+TDCHit *xhptdc8_hit_ring_claim(xhptdc8_hit_ring *ring) {
+    if (nullptr == ring) {
+        return nullptr;
+    }
+    uint64_t position = ring->write_position.load(std::memory_order_relaxed);
+    if (XHPTDC8_HIT_RING_SPSC == ring->mode) {
+        if (position - ring->cached_read_position >= ring->slot_count) {
+            ring->cached_read_position = ring->read_position.load(std::memory_order_acquire);
+            if (position - ring->cached_read_position >= ring->slot_count) {
+                return nullptr;
+            }
+        }
+        hit_ring_slot *slot = &ring->slots[position & (ring->slot_count - 1)];
+        slot->position = position;
+        return ring->hits + (position & (ring->slot_count - 1)) * ring->batch_hits;
+    }
+
+    while (true) {
+        hit_ring_slot *slot = &ring->slots[position & (ring->slot_count - 1)];
+        int64_t difference =
+            static_cast<int64_t>(slot->sequence.load(std::memory_order_acquire) - position);
+        if (0 == difference) {
+            if (ring->write_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                slot->position = position;
+                return ring->hits + (position & (ring->slot_count - 1)) * ring->batch_hits;
+            }
+        } else if (difference < 0) {
+            // The slot was not yet released since the last round
+            return nullptr;
+        } else {
+            position = ring->write_position.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+int xhptdc8_hit_ring_commit(xhptdc8_hit_ring *ring, TDCHit *batch, size_t hit_count) {
+    if (nullptr == ring) {
+        return XHPTDC8_INVALID_ARGUMENTS;
+    }
+    size_t slot_index = get_slot_index(ring, batch);
+    if (slot_index >= ring->slot_count || hit_count > ring->batch_hits) {
+        return XHPTDC8_INVALID_ARGUMENTS;
+    }
+    hit_ring_slot *slot = &ring->slots[slot_index];
+    slot->hit_count = hit_count;
+    if (XHPTDC8_HIT_RING_SPSC == ring->mode) {
+        ring->write_position.store(slot->position + 1, std::memory_order_release);
+    } else {
+        slot->sequence.store(slot->position + 1, std::memory_order_release);
+    }
+    return XHPTDC8_OK;
+}
+
+const TDCHit *xhptdc8_hit_ring_acquire(xhptdc8_hit_ring *ring, size_t *hit_count) {
+    if (nullptr == ring || nullptr == hit_count) {
+        return nullptr;
+    }
+    uint64_t position = ring->read_position.load(std::memory_order_relaxed);
+    if (XHPTDC8_HIT_RING_SPSC == ring->mode) {
+        if (position == ring->cached_write_position) {
+            ring->cached_write_position = ring->write_position.load(std::memory_order_acquire);
+            if (position == ring->cached_write_position) {
+                return nullptr;
+            }
+        }
+        hit_ring_slot *slot = &ring->slots[position & (ring->slot_count - 1)];
+        slot->position = position;
+        *hit_count = slot->hit_count;
+        return ring->hits + (position & (ring->slot_count - 1)) * ring->batch_hits;
+    }
+
+    while (true) {
+        hit_ring_slot *slot = &ring->slots[position & (ring->slot_count - 1)];
+        int64_t difference =
+            static_cast<int64_t>(slot->sequence.load(std::memory_order_acquire) - (position + 1));
+        if (0 == difference) {
+            if (ring->read_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                slot->position = position;
+                *hit_count = slot->hit_count;
+                return ring->hits + (position & (ring->slot_count - 1)) * ring->batch_hits;
+            }
+        } else if (difference < 0) {
+            // The slot was not yet committed
+            return nullptr;
+        } else {
+            position = ring->read_position.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+int xhptdc8_hit_ring_release(xhptdc8_hit_ring *ring, const TDCHit *batch) {
+    if (nullptr == ring) {
+        return XHPTDC8_INVALID_ARGUMENTS;
+    }
+    size_t slot_index = get_slot_index(ring, batch);
+    if (slot_index >= ring->slot_count) {
+        return XHPTDC8_INVALID_ARGUMENTS;
+    }
+    hit_ring_slot *slot = &ring->slots[slot_index];
+    if (XHPTDC8_HIT_RING_SPSC == ring->mode) {
+        ring->read_position.store(slot->position + 1, std::memory_order_release);
+    } else {
+        slot->sequence.store(slot->position + ring->slot_count, std::memory_order_release);
+    }
+    return XHPTDC8_OK;
+}
+
+int xhptdc8_hit_ring_push(xhptdc8_hit_ring *ring, const TDCHit *hits, size_t hit_count) {
+    if (nullptr == ring || (nullptr == hits && hit_count > 0) || hit_count > ring->batch_hits) {
+        return XHPTDC8_INVALID_ARGUMENTS;
+    }
+    TDCHit *batch = xhptdc8_hit_ring_claim(ring);
+    if (nullptr == batch) {
+        return 0;
+    }
+    if (hit_count > 0) {
+        memcpy(batch, hits, hit_count * sizeof(TDCHit));
+    }
+    xhptdc8_hit_ring_commit(ring, batch, hit_count);
+    return 1;
+}
+
+int xhptdc8_hit_ring_pop(xhptdc8_hit_ring *ring, TDCHit *hit_buf, size_t max_hits) {
+    if (nullptr == ring || nullptr == hit_buf || max_hits < ring->batch_hits) {
+        return XHPTDC8_INVALID_ARGUMENTS;
+    }
+    size_t hit_count;
+    const TDCHit *batch = xhptdc8_hit_ring_acquire(ring, &hit_count);
+    if (nullptr == batch) {
+        return -1;
+    }
+    if (hit_count > 0) {
+        memcpy(hit_buf, batch, hit_count * sizeof(TDCHit));
+    }
+    xhptdc8_hit_ring_release(ring, batch);
+    return static_cast<int>(hit_count);
+}
+
+struct xhptdc8_async_capture_ {
+    xhptdc8_hit_ring *ring;
+    std::thread thread;
+    std::atomic<bool> stop;
+    // Set once the thread is pinned to its CPUs, the loop does not read before
+    std::atomic<bool> started;
+    xhptdc8_async_capture_stats stats;
+};
+
+// Longest time the read loop blocks before checking for xhptdc8_stop_async_capture()
+#define ASYNC_CAPTURE_WAIT_NS 1000000
+// Sleep of the read loop while the ring is full or the driver cannot wait for hits
+#define ASYNC_CAPTURE_SLEEP_US 50
+
+typedef int (*wait_for_hits_function)(size_t min_hits, int64_t timeout_ns);
+
+static wait_for_hits_function get_wait_for_hits() {
+#ifdef _WIN32
+    HMODULE driver = GetModuleHandleA("xhptdc8_driver_64.dll");
+    if (nullptr == driver) {
+        return nullptr;
+    }
+    return reinterpret_cast<wait_for_hits_function>(GetProcAddress(driver, "xhptdc8_wait_for_hits"));
+#else
+    return xhptdc8_wait_for_hits;
+#endif
+}
+
+static void async_capture_loop(xhptdc8_async_capture *capture) {
+    wait_for_hits_function wait_for_hits = get_wait_for_hits();
+    TDCHit *batch = nullptr;
+    while (!capture->started.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+    while (!capture->stop.load(std::memory_order_relaxed)) {
+        if (nullptr == batch) {
+            batch = xhptdc8_hit_ring_claim(capture->ring);
+            if (nullptr == batch) {
+                // Wait for the consumers, the hits stay in the host buffer of the driver meanwhile
+                capture->stats.ring_full++;
+                std::this_thread::sleep_for(std::chrono::microseconds(ASYNC_CAPTURE_SLEEP_US));
+                continue;
+            }
+        }
+        int hit_count = xhptdc8_read_hits(batch, capture->ring->batch_hits);
+        if (hit_count < 0) {
+            capture->stats.error_code = hit_count;
+            break;
+        }
+        if (0 == hit_count) {
+            // The claimed batch is kept for the next read. Sleep in the driver until hits arrive, or for a short
+            // time if the driver cannot wait
+            int result = XHPTDC8_INTERNAL_ERROR;
+            if (nullptr != wait_for_hits) {
+                result = wait_for_hits(1, ASYNC_CAPTURE_WAIT_NS);
+            }
+            if (XHPTDC8_OK != result && XHPTDC8_INSUFFICIENT_DATA != result) {
+                std::this_thread::sleep_for(std::chrono::microseconds(ASYNC_CAPTURE_SLEEP_US));
+            }
+            continue;
+        }
+        xhptdc8_hit_ring_commit(capture->ring, batch, static_cast<size_t>(hit_count));
+        batch = nullptr;
+        capture->stats.hits += static_cast<uint64_t>(hit_count);
+        capture->stats.batches++;
+    }
+    if (nullptr != batch && XHPTDC8_HIT_RING_MPMC == capture->ring->mode) {
+        // The claim of a MPMC ring cannot be undone, the batch must be committed so later batches become
+        // available. A claimed batch of a SPSC ring is simply claimed again by the next producer.
+        xhptdc8_hit_ring_commit(capture->ring, batch, 0);
+    }
+}
+
+static bool set_thread_affinity(std::thread &thread, uint64_t cpu_mask) {
+    if (0 == cpu_mask) {
+        return true;
+    }
+#ifdef _WIN32
+    return 0 != SetThreadAffinityMask(thread.native_handle(), static_cast<DWORD_PTR>(cpu_mask));
+#elif defined(__linux__)
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu = 0; cpu < 64; cpu++) {
+        if ((cpu_mask >> cpu) & 1) {
+            CPU_SET(cpu, &cpu_set);
+        }
+    }
+    return 0 == pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set), &cpu_set);
+#else
+    return true;
+#endif
+}
+
+xhptdc8_async_capture *xhptdc8_start_async_capture(xhptdc8_hit_ring *ring, uint64_t cpu_mask) {
+    if (nullptr == ring) {
+        return nullptr;
+    }
+    xhptdc8_async_capture *capture = new (std::nothrow) xhptdc8_async_capture;
+    if (nullptr == capture) {
+        return nullptr;
+    }
+    capture->ring = ring;
+    capture->stop.store(false);
+    capture->started.store(false);
+    memset(&capture->stats, 0, sizeof(capture->stats));
+    try {
+        capture->thread = std::thread(async_capture_loop, capture);
+    } catch (const std::system_error &) {
+        delete capture;
+        return nullptr;
+    }
+    if (!set_thread_affinity(capture->thread, cpu_mask)) {
+        // The loop ends before reading any hits
+        capture->stop.store(true);
+        capture->started.store(true, std::memory_order_release);
+        capture->thread.join();
+        delete capture;
+        return nullptr;
+    }
+    capture->started.store(true, std::memory_order_release);
+    return capture;
+}
+
+int xhptdc8_stop_async_capture(xhptdc8_async_capture *capture, xhptdc8_async_capture_stats *stats) {
+    if (nullptr == capture) {
+        return XHPTDC8_INVALID_ARGUMENTS;
+    }
+    capture->stop.store(true);
+    capture->thread.join();
+    if (nullptr != stats) {
+        *stats = capture->stats;
+    }
+    delete capture;
+    return XHPTDC8_OK;
+}
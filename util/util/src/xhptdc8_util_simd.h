@@ -0,0 +1,63 @@
+#ifndef _UTIL_SIMD_H__
+#define _UTIL_SIMD_H__
+
+// Run time selection of the SIMD kernels, the library itself is built for the baseline instruction set
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMD_X86_64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__)
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SIMD_TARGET(isa)
+#endif
+
+enum simd_level { SIMD_NONE, SIMD_AVX2, SIMD_AVX512 };
+
+#ifdef SIMD_X86_64
+inline simd_level detect_simd_level() {
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return SIMD_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return SIMD_AVX2;
+    }
+    return SIMD_NONE;
+#else
+    int regs[4];
+    __cpuid(regs, 1);
+    // The OS saves the AVX registers
+    bool osxsave = (regs[2] & (1 << 27)) != 0;
+    if (!osxsave) {
+        return SIMD_NONE;
+    }
+    unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(regs, 7, 0);
+    if ((regs[1] & (1 << 16)) && (xcr0 & 0xE6) == 0xE6) {
+        return SIMD_AVX512;
+    }
+    if ((regs[1] & (1 << 5)) && (xcr0 & 0x6) == 0x6) {
+        return SIMD_AVX2;
+    }
+    return SIMD_NONE;
+#endif
+}
+#endif
+
+inline simd_level get_simd_level() {
+#ifdef SIMD_X86_64
+    static const simd_level level = detect_simd_level();
+    return level;
+#else
+    return SIMD_NONE;
+#endif
+}
+
+#endif
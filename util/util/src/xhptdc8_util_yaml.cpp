@@ -371,7 +371,8 @@ int xhptdc8_apply_trigger_yaml(const ryml::NodeRef *device_config_node, xhptdc8_
  *        N: Count of successfully updated channel
  *       -ve: Error
  */
-int xhptdc8_apply_channel_yaml(const ryml::NodeRef *device_config_node, xhptdc8_device_configuration *device_config) {
+int xhptdc8_apply_channel_yaml(const ryml::NodeRef *device_config_node, xhptdc8_device_configuration *device_config,
+                               int64_t *channel_offset) {
     VALIDATE_APPLY_YAMAL_PARAMS;
 
     ryml::NodeRef channel_node = (*device_config_node).find_child("channel");
@@ -442,6 +443,9 @@ int xhptdc8_apply_channel_yaml(const ryml::NodeRef *device_config_node, xhptdc8_
 
         APPLY_CHILD_BOOL_VALUE(child_node, "rising", device_config->channel[channel_index].rising,
                                XHPTDC8_APPLY_YAML_INVALID_CHANNEL_RISING);
+
+        APPLY_CHILD_LONGLONG_VALUE(child_node, "offset", true, channel_offset[channel_index],
+                                   XHPTDC8_APPLY_YAML_INVALID_CHANNEL_OFFSET);
     }
 
     return apply_first_on_all_elements ? XHPTDC8_TDC_CHANNEL_COUNT : channel_children_count;
@@ -453,7 +457,7 @@ int xhptdc8_apply_channel_yaml(const ryml::NodeRef *device_config_node, xhptdc8_
  *       -ve: Error
  */
 int xhptdc8_apply_adc_channel_yaml(const ryml::NodeRef *device_config_node,
-                                   xhptdc8_device_configuration *device_config) {
+                                   xhptdc8_device_configuration *device_config, int64_t *channel_offset) {
     VALIDATE_APPLY_YAMAL_PARAMS;
 
     ryml::NodeRef adc_channel_node = (*device_config_node).find_child("adc_channel");
@@ -477,6 +481,18 @@ int xhptdc8_apply_adc_channel_yaml(const ryml::NodeRef *device_config_node,
                              device_config->adc_channel.trigger_threshold,
                              XHPTDC8_APPLY_YAML_INVALID_ADC_CHANNEL_TRTHRESH);
 
+    // offset, the ADC hits are on both channels behind the TDC channels
+    ryml::NodeRef offset_node = adc_channel_node.find_child("offset");
+    if (RYML_NODE_EXISTS_AND_HAS_VAL(offset_node)) {
+        long long val;
+        if (!_node_val_toll_internal(&offset_node, &val)) {
+            return XHPTDC8_APPLY_YAML_INVALID_ADC_CHANNEL_OFFSET;
+        }
+        channel_offset[XHPTDC8_TDC_CHANNEL_COUNT] = val;
+        channel_offset[XHPTDC8_TDC_CHANNEL_COUNT + 1] = val;
+        VERBOSE_DEBUG_MSG_YAML_APPLIED_LL(adc_channel_node, "offset", val);
+    }
+
     return 1;
 }
 
@@ -822,7 +838,7 @@ int xhptdc8_apply_grouping_yaml(const ryml::NodeRef *config_mngr_node, xhptdc8_m
  *       -ve: Error
  */
 int xhptdc8_apply_device_config_yaml(const ryml::NodeRef *device_config_node,
-                                     xhptdc8_device_configuration *device_config) {
+                                     xhptdc8_device_configuration *device_config, int64_t *channel_offset) {
     VALIDATE_APPLY_YAMAL_PARAMS;
 
     // auto_trigger_periods
@@ -860,12 +876,12 @@ int xhptdc8_apply_device_config_yaml(const ryml::NodeRef *device_config_node,
         return result;
     }
     // channel
-    result = xhptdc8_apply_channel_yaml(device_config_node, device_config);
+    result = xhptdc8_apply_channel_yaml(device_config_node, device_config, channel_offset);
     if (result < 0) {
         return result;
     }
     // adc_channel
-    result = xhptdc8_apply_adc_channel_yaml(device_config_node, device_config);
+    result = xhptdc8_apply_adc_channel_yaml(device_config_node, device_config, channel_offset);
     if (result < 0) {
         return result;
     }
@@ -970,8 +986,9 @@ extern "C" int xhptdc8_apply_yaml(xhptdc8_manager_configuration *manager_config,
                 // Skip the element
                 continue;
             }
-            int result =
-                xhptdc8_apply_device_config_yaml(&child_node, &(manager_config->device_configs[device_config_index]));
+            int result = xhptdc8_apply_device_config_yaml(
+                &child_node, &(manager_config->device_configs[device_config_index]),
+                &(manager_config->channel_offset[device_config_index * XHPTDC8_NOF_CHANNELS_PER_CARD]));
             if (result < 0) {
                 return result;
             }
@@ -6,12 +6,48 @@
 #include <vector>
 #include <string>
 #include <istream>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
 #include "xhptdc8_util.h"
 #include "xHPTDC8_interface.h"
 using namespace std;
 
 int test_apply_yaml(const char* src);
 int display_all_error_messages(crono_bool_t include_ok, crono_bool_t fixed_length);
+int benchmark_group_matrix(int seconds);
+int benchmark_hit_ring();
+int benchmark_merger();
+int benchmark_bins_to_ps();
+int benchmark_channel_offsets();
+int stress_status_queries(int seconds);
+int check_readout_stats(int seconds);
+
+// Statistics functions that the dummy driver exports, but not every driver. NULL if not exported
+typedef int (*get_readout_stats_function)(int index, xhptdc8_readout_stats* stats);
+typedef int (*get_callback_stats_function)(xhptdc8_callback_stats* stats);
+#ifdef _WIN32
+static FARPROC get_driver_function(const char* name)
+{
+	HMODULE driver = GetModuleHandleA("xhptdc8_driver_64.dll");
+	return (nullptr == driver) ? nullptr : GetProcAddress(driver, name);
+}
+static get_readout_stats_function get_readout_stats =
+	reinterpret_cast<get_readout_stats_function>(get_driver_function("xhptdc8_get_readout_stats"));
+static get_callback_stats_function get_callback_stats =
+	reinterpret_cast<get_callback_stats_function>(get_driver_function("xhptdc8_get_callback_stats"));
+#else
+#pragma weak xhptdc8_get_readout_stats
+#pragma weak xhptdc8_get_callback_stats
+static get_readout_stats_function get_readout_stats = xhptdc8_get_readout_stats;
+static get_callback_stats_function get_callback_stats = xhptdc8_get_callback_stats;
+#endif
 
 void display_intro()
 {
@@ -35,6 +71,31 @@ void display_about()
 	printf("\n");
 	printf("-errmsg    : displays error messages.\n");
 	printf("\n");
+	printf("-benchmatrix : captures groups for some seconds using \"xhptdc8_read_group_matrix\" \n");
+	printf("             and using \"xhptdc8_read_hits\" with a loop sorting the hits by \n");
+	printf("             channel, then displays the median time per group of both.\n");
+	printf("\n");
+	printf("-benchring : measures the throughput of the SPSC and MPMC hit rings between \n");
+	printf("             threads for several batch sizes.\n");
+	printf("\n");
+	printf("-benchmerge : measures the throughput of merging the hits of six boards \n");
+	printf("             by time using \"xhptdc8_merger_pop\".\n");
+	printf("\n");
+	printf("-benchbins : measures the conversion of TDC bins to picoseconds using \n");
+	printf("             \"xhptdc8_bins_to_ps\" and \"xhptdc8_hits_bins_to_ps\" against a \n");
+	printf("             loop multiplying every hit.\n");
+	printf("\n");
+	printf("-benchoffsets : measures the correction of hits by the channel offsets using \n");
+	printf("             \"xhptdc8_apply_channel_offsets\" against a loop correcting every \n");
+	printf("             hit followed by a sort.\n");
+	printf("\n");
+	printf("-stressstatus : reads hits while 0 to 16 threads poll the status functions, \n");
+	printf("             then displays the longest \"xhptdc8_read_hits\" call and the number \n");
+	printf("             of polls for each number of polling threads.\n");
+	printf("\n");
+	printf("-readoutstats : reads hits for a second, then checks that the counters of \n");
+	printf("             \"xhptdc8_get_readout_stats\" grew with the hits and calls read.\n");
+	printf("\n");
 	printf("-help      : displays this help.\n");
 	printf("\n");
 	printf("\n");
@@ -46,6 +107,7 @@ void display_about()
 int main(int argc,  char* argv[])  
 {
 	int count;
+	int failures = 0;
 
 	// Display each command-line argument.
 	if (1 == argc)
@@ -69,6 +131,41 @@ int main(int argc,  char* argv[])
 			display_intro();
 			display_all_error_messages(true, true);
 		}
+		else if (!strcmp(argv[count], "-benchmatrix"))
+		{
+			display_intro();
+			benchmark_group_matrix(2);
+		}
+		else if (!strcmp(argv[count], "-benchring"))
+		{
+			display_intro();
+			benchmark_hit_ring();
+		}
+		else if (!strcmp(argv[count], "-benchmerge"))
+		{
+			display_intro();
+			benchmark_merger();
+		}
+		else if (!strcmp(argv[count], "-benchbins"))
+		{
+			display_intro();
+			benchmark_bins_to_ps();
+		}
+		else if (!strcmp(argv[count], "-benchoffsets"))
+		{
+			display_intro();
+			benchmark_channel_offsets();
+		}
+		else if (!strcmp(argv[count], "-stressstatus"))
+		{
+			display_intro();
+			failures += stress_status_queries(2);
+		}
+		else if (!strcmp(argv[count], "-readoutstats"))
+		{
+			display_intro();
+			failures += check_readout_stats(1);
+		}
 		else if (!strcmp(argv[count], "-yamlentry"))
 		{
 			display_intro();
@@ -102,7 +199,7 @@ int main(int argc,  char* argv[])
 			display_about();
 		}
 	}
-	return 0;
+	return failures;
 }
 
 int test_apply_yaml(const char* src)
@@ -117,7 +214,7 @@ int test_apply_yaml(const char* src)
         return error_code;
     }
 	xhptdc8_manager_configuration* cfg = new xhptdc8_manager_configuration;
-	error_code = xhptdc8_get_default_configuration(cfg);
+	error_code = xhptdc8_init_configuration(cfg);
     if (XHPTDC8_OK != error_code) {
         printf("Error getting defaut configuration, %d\n", error_code);
     	delete cfg;
@@ -153,3 +250,457 @@ int display_all_error_messages(crono_bool_t include_ok, crono_bool_t fixed_lengt
 	xhptdc8_close();
 	return 0;
 }
+
+int benchmark_group_matrix(int seconds)
+{
+	const int number_of_tdcs = 1;
+	const int number_of_channels = number_of_tdcs * XHPTDC8_NOF_CHANNELS_PER_CARD;
+	const int number_of_hits = 64;
+	const size_t hit_buf_size = 10000;
+	xhptdc8_manager_init_parameters params;
+	int error_code;
+
+	xhptdc8_get_default_init_parameters(&params);
+	error_code = xhptdc8_init(&params);
+	if (XHPTDC8_OK != error_code) {
+		printf("Error initializing the device, %d\n", error_code);
+		return error_code;
+	}
+	xhptdc8_manager_configuration* cfg = new xhptdc8_manager_configuration;
+	xhptdc8_init_configuration(cfg);
+	cfg->grouping.enabled = true;
+	cfg->grouping.trigger_channel = 0;
+	cfg->grouping.range_start = 0;
+	cfg->grouping.range_stop = 100000;
+	error_code = xhptdc8_configure(cfg);
+	delete cfg;
+	if (XHPTDC8_OK != error_code) {
+		printf("Error configuring the device, %d\n", error_code);
+		xhptdc8_close();
+		return error_code;
+	}
+
+	int64_t trigger_timestamp;
+	vector<int32_t> hit_counter(number_of_channels);
+	vector<int64_t> tdc_array(number_of_channels * number_of_hits);
+	vector<int32_t> adc_counter(number_of_tdcs);
+	vector<int32_t> adc_value(number_of_tdcs);
+	vector<TDCHit> hit_buf(hit_buf_size);
+
+	for (int method = 0; method < 2; method++)
+	{
+		long hits = 0;
+		vector<double> read_us;
+		xhptdc8_start_capture();
+		auto end = chrono::steady_clock::now() + chrono::seconds(seconds);
+		while (chrono::steady_clock::now() < end)
+		{
+			auto start = chrono::steady_clock::now();
+			int result;
+			if (0 == method) {
+				result = xhptdc8_read_group_matrix(&trigger_timestamp, hit_counter.data(), tdc_array.data(),
+					adc_counter.data(), adc_value.data(), number_of_tdcs, number_of_channels, number_of_hits);
+			}
+			else {
+				result = xhptdc8_read_hits(hit_buf.data(), hit_buf_size);
+				for (int channel = 0; channel < number_of_channels; channel++) {
+					hit_counter[channel] = 0;
+				}
+				for (int hit_index = 0; hit_index < result; hit_index++) {
+					int channel = hit_buf[hit_index].channel;
+					if (channel < number_of_channels && hit_counter[channel] < number_of_hits) {
+						tdc_array[channel * number_of_hits + hit_counter[channel]] = hit_buf[hit_index].time;
+						hit_counter[channel]++;
+					}
+				}
+			}
+			if (result < 0) {
+				printf("Error reading hits, %d\n", result);
+				break;
+			}
+			if (result > 0) {
+				// Polls without a group are not measured
+				read_us.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+				hits += result;
+			}
+		}
+		xhptdc8_stop_capture();
+		// The median, as a call preempted by the operating system would dominate the mean
+		size_t groups = read_us.size();
+		nth_element(read_us.begin(), read_us.begin() + groups / 2, read_us.end());
+		printf("%-26s: %zu groups, %ld hits, %.3f us per group\n",
+			0 == method ? "xhptdc8_read_group_matrix" : "xhptdc8_read_hits + loop",
+			groups, hits, groups > 0 ? read_us[groups / 2] : 0.0);
+	}
+	xhptdc8_close();
+	return 0;
+}
+
+int benchmark_hit_ring()
+{
+	const size_t batch_count = 64;
+	const size_t total_hits = 64 * 1024 * 1024;
+	const size_t batch_sizes[] = { 1, 16, 256, 4096 };
+
+	for (int mode = XHPTDC8_HIT_RING_SPSC; mode <= XHPTDC8_HIT_RING_MPMC; mode++)
+	{
+		// Two producers and two consumers for MPMC
+		const int thread_count = (XHPTDC8_HIT_RING_SPSC == mode) ? 1 : 2;
+		for (size_t batch_hits : batch_sizes)
+		{
+			xhptdc8_hit_ring* ring = xhptdc8_create_hit_ring(mode, batch_count, batch_hits);
+			if (nullptr == ring) {
+				printf("Error creating the ring\n");
+				return -1;
+			}
+			const size_t batches_per_thread = total_hits / batch_hits / 16 / thread_count + 1;
+			vector<thread> threads;
+			auto start = chrono::steady_clock::now();
+			for (int producer = 0; producer < thread_count; producer++) {
+				threads.emplace_back([ring, batch_hits, batches_per_thread] {
+					for (size_t batch_index = 0; batch_index < batches_per_thread; batch_index++) {
+						TDCHit* batch;
+						while (nullptr == (batch = xhptdc8_hit_ring_claim(ring))) {
+							this_thread::yield();
+						}
+						batch[0].time = (int64_t)batch_index;
+						xhptdc8_hit_ring_commit(ring, batch, batch_hits);
+					}
+				});
+			}
+			for (int consumer = 0; consumer < thread_count; consumer++) {
+				threads.emplace_back([ring, batches_per_thread] {
+					int64_t sum = 0;
+					for (size_t batch_index = 0; batch_index < batches_per_thread; batch_index++) {
+						size_t hit_count;
+						const TDCHit* batch;
+						while (nullptr == (batch = xhptdc8_hit_ring_acquire(ring, &hit_count))) {
+							this_thread::yield();
+						}
+						sum += batch[0].time;
+						xhptdc8_hit_ring_release(ring, batch);
+					}
+					if (sum < 0) {
+						printf("Invalid data\n");
+					}
+				});
+			}
+			for (thread& t : threads) {
+				t.join();
+			}
+			double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			double batches = (double)batches_per_thread * thread_count;
+			printf("%s batch %5zu hits: %8.2f M batches/s, %8.2f M hits/s\n",
+				XHPTDC8_HIT_RING_SPSC == mode ? "SPSC" : "MPMC", batch_hits,
+				batches / seconds / 1e6, batches * batch_hits / seconds / 1e6);
+			xhptdc8_destroy_hit_ring(ring);
+		}
+	}
+	return 0;
+}
+
+int benchmark_merger()
+{
+	const int board_count = XHPTDC8_MANAGER_DEVICES_MAX;
+	const size_t block_hits = 64 * 1024;
+	const int block_count = 256;
+	const size_t run_lengths[] = { 1, 16, 256 };
+
+	vector<TDCHit> block(block_hits);
+	vector<TDCHit> merged(2 * block_hits);
+	for (size_t run_hits : run_lengths)
+	{
+		xhptdc8_merger* merger = xhptdc8_create_merger(board_count, XHPTDC8_MERGER_LATENCY(1000));
+		if (nullptr == merger) {
+			printf("Error creating the merger\n");
+			return -1;
+		}
+		// Each board delivers runs of run_hits consecutive hits, hits of the boards 
+		// interleave in time and arrive in blocks as returned by xhptdc8_read_hits
+		int64_t time = 0;
+		size_t merged_hits = 0;
+		double seconds = 0;
+		for (int block_index = 0; block_index < block_count; block_index++) {
+			for (size_t hit_index = 0; hit_index < block_hits; hit_index++) {
+				size_t run = hit_index / run_hits;
+				block[hit_index].channel = (uint8_t)((run % board_count) * XHPTDC8_NOF_CHANNELS_PER_CARD);
+				block[hit_index].type = 0;
+				block[hit_index].bin = 0;
+				block[hit_index].time = time + (int64_t)((run / board_count) * run_hits + hit_index % run_hits) * 100
+					+ (int64_t)(run % board_count);
+			}
+			time += (int64_t)(block_hits / board_count + run_hits) * 100;
+			auto start = chrono::steady_clock::now();
+			xhptdc8_merger_push(merger, block.data(), block.size());
+			int popped;
+			while ((popped = xhptdc8_merger_pop(merger, merged.data(), merged.size(), false)) > 0) {
+				merged_hits += popped;
+			}
+			seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		}
+		printf("%d boards, runs of %3zu hits: %8.2f M hits/s\n", board_count, run_hits, 
+			merged_hits / seconds / 1e6);
+		xhptdc8_destroy_merger(merger);
+	}
+	return 0;
+}
+
+int benchmark_bins_to_ps()
+{
+	const double binsize = 1000 / 76.8;
+	const size_t hit_count = 64 * 1024;
+	const int repeat_count = 2000;
+
+	vector<int64_t> bins(hit_count);
+	vector<int64_t> ps(hit_count);
+	vector<TDCHit> hits(hit_count);
+	for (size_t hit_index = 0; hit_index < hit_count; hit_index++) {
+		bins[hit_index] = (int64_t)hit_index * 76800;
+	}
+	for (int method = 0; method < 3; method++)
+	{
+		double seconds = 0;
+		for (int repeat = 0; repeat < repeat_count; repeat++) {
+			for (size_t hit_index = 0; hit_index < hit_count; hit_index++) {
+				hits[hit_index].time = bins[hit_index];
+			}
+			auto start = chrono::steady_clock::now();
+			switch (method) {
+			case 0:
+				for (size_t hit_index = 0; hit_index < hit_count; hit_index++) {
+					hits[hit_index].time = llround(hits[hit_index].time * binsize);
+				}
+				break;
+			case 1:
+				xhptdc8_hits_bins_to_ps(binsize, hits.data(), hit_count);
+				break;
+			default:
+				xhptdc8_bins_to_ps(binsize, bins.data(), ps.data(), hit_count);
+				break;
+			}
+			seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		}
+		const char* names[] = { "llround(time * binsize)", "xhptdc8_hits_bins_to_ps", "xhptdc8_bins_to_ps" };
+		printf("%-24s: %8.2f M hits/s\n", names[method], (double)hit_count * repeat_count / seconds / 1e6);
+	}
+	return 0;
+}
+
+int benchmark_channel_offsets()
+{
+	const size_t hit_count = 64 * 1024;
+	const int repeat_count = 1000;
+
+	xhptdc8_manager_configuration mgr_cfg;
+	xhptdc8_init_configuration(&mgr_cfg);
+	vector<TDCHit> source(hit_count);
+	vector<TDCHit> hits(hit_count);
+	for (size_t hit_index = 0; hit_index < hit_count; hit_index++) {
+		source[hit_index].time = (int64_t)hit_index * 10000;
+		source[hit_index].channel = (uint8_t)(hit_index % XHPTDC8_CHANNEL_OFFSET_COUNT);
+	}
+	// Offsets below the time between the hits keep the order, larger ones require a sort
+	const int64_t max_offsets[] = { 1000, 50000 };
+	for (int64_t max_offset : max_offsets)
+	{
+		for (int channel = 0; channel < XHPTDC8_CHANNEL_OFFSET_COUNT; channel++) {
+			mgr_cfg.channel_offset[channel] = (channel * 7919) % (2 * max_offset + 1) - max_offset;
+		}
+		for (int method = 0; method < 2; method++)
+		{
+			double seconds = 0;
+			for (int repeat = 0; repeat < repeat_count; repeat++) {
+				hits = source;
+				auto start = chrono::steady_clock::now();
+				if (0 == method) {
+					for (size_t hit_index = 0; hit_index < hit_count; hit_index++) {
+						hits[hit_index].time += mgr_cfg.channel_offset[hits[hit_index].channel];
+					}
+					stable_sort(hits.begin(), hits.end(),
+						[](const TDCHit& a, const TDCHit& b) { return a.time < b.time; });
+				}
+				else {
+					xhptdc8_apply_channel_offsets(&mgr_cfg, -1, hits.data(), hit_count);
+				}
+				seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			}
+			const char* names[] = { "loop and stable_sort", "xhptdc8_apply_channel_offsets" };
+			printf("offsets up to %6lld ps, %-30s: %8.2f M hits/s\n", (long long)max_offset, names[method],
+				(double)hit_count * repeat_count / seconds / 1e6);
+		}
+	}
+	return 0;
+}
+
+int stress_status_queries(int seconds)
+{
+	const int poller_counts[] = { 0, 1, 4, 16 };
+	const size_t hit_buf_size = 10000;
+	xhptdc8_manager_init_parameters params;
+	int error_code;
+
+	xhptdc8_get_default_init_parameters(&params);
+	error_code = xhptdc8_init(&params);
+	if (XHPTDC8_OK != error_code) {
+		printf("Error initializing the device, %d\n", error_code);
+		return error_code;
+	}
+	xhptdc8_manager_configuration* cfg = new xhptdc8_manager_configuration;
+	xhptdc8_init_configuration(cfg);
+	error_code = xhptdc8_configure(cfg);
+	delete cfg;
+	if (XHPTDC8_OK != error_code) {
+		printf("Error configuring the device, %d\n", error_code);
+		xhptdc8_close();
+		return error_code;
+	}
+	xhptdc8_static_info expected_static_info;
+	xhptdc8_get_static_info(0, &expected_static_info);
+
+	vector<TDCHit> hit_buf(hit_buf_size);
+	int failures = 0;
+	for (int poller_count : poller_counts)
+	{
+		atomic<bool> stop(false);
+		atomic<long> polls(0);
+		atomic<long> wrong_results(0);
+		vector<thread> pollers;
+		xhptdc8_start_capture();
+		for (int poller = 0; poller < poller_count; poller++) {
+			pollers.emplace_back([&]() {
+				// The counters of the statistics never decrease
+				xhptdc8_readout_stats last_readout_stats = {};
+				while (!stop.load(memory_order_relaxed)) {
+					xhptdc8_fast_info fast_info;
+					xhptdc8_param_info param_info;
+					xhptdc8_static_info static_info;
+					xhptdc8_temperature_info temperature_info;
+					xhptdc8_clock_info clock_info;
+					crono_pcie_info pcie_info;
+					int64_t timestamp;
+					// The status must not change while capturing, a torn copy would differ
+					bool wrong = XHPTDC8_OK != xhptdc8_get_fast_info(0, &fast_info) ||
+						XHPTDC8_DEVICE_STATE_CAPTURING != fast_info.state ||
+						XHPTDC8_OK != xhptdc8_get_param_info(0, &param_info) ||
+						XHPTDC8_OK != xhptdc8_get_static_info(0, &static_info) ||
+						0 != memcmp(&static_info, &expected_static_info, sizeof(xhptdc8_static_info)) ||
+						XHPTDC8_OK != xhptdc8_get_temperature_info(0, &temperature_info) ||
+						XHPTDC8_OK != xhptdc8_get_clock_info(0, &clock_info) ||
+						XHPTDC8_OK != xhptdc8_get_pcie_info(0, &pcie_info) ||
+						XHPTDC8_OK != xhptdc8_get_current_timestamp(0, &timestamp);
+					if (nullptr != get_readout_stats) {
+						xhptdc8_readout_stats readout_stats;
+						wrong = wrong || XHPTDC8_OK != get_readout_stats(0, &readout_stats) ||
+							readout_stats.read_calls < last_readout_stats.read_calls ||
+							readout_stats.delivered_hits < last_readout_stats.delivered_hits ||
+							readout_stats.written_hits < last_readout_stats.written_hits;
+						last_readout_stats = readout_stats;
+					}
+					if (nullptr != get_callback_stats) {
+						// No hit callback is registered
+						xhptdc8_callback_stats callback_stats;
+						wrong = wrong || XHPTDC8_OK != get_callback_stats(&callback_stats) ||
+							0 != callback_stats.callback_calls;
+					}
+					if (wrong) {
+						wrong_results++;
+					}
+					polls++;
+				}
+			});
+		}
+
+		long reads = 0;
+		long hits = 0;
+		double max_read_seconds = 0;
+		auto end = chrono::steady_clock::now() + chrono::seconds(seconds);
+		while (chrono::steady_clock::now() < end)
+		{
+			auto start = chrono::steady_clock::now();
+			int result = xhptdc8_read_hits(hit_buf.data(), hit_buf_size);
+			max_read_seconds = max(max_read_seconds, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+			if (result < 0) {
+				printf("Error reading hits, %d\n", result);
+				break;
+			}
+			reads++;
+			hits += result;
+		}
+		stop = true;
+		for (thread& poller : pollers) {
+			poller.join();
+		}
+		xhptdc8_stop_capture();
+		printf("%d polling threads: %ld reads, %ld hits, longest read %.1f us, %ld polls, %ld wrong\n",
+			poller_count, reads, hits, max_read_seconds * 1e6, polls.load(), wrong_results.load());
+		failures += wrong_results > 0;
+	}
+	xhptdc8_close();
+	return failures;
+}
+
+int check_readout_stats(int seconds)
+{
+	const size_t hit_buf_size = 10000;
+	xhptdc8_manager_init_parameters params;
+	int error_code;
+
+	if (nullptr == get_readout_stats) {
+		printf("xhptdc8_get_readout_stats is not exported by the driver\n");
+		return 0;
+	}
+	xhptdc8_get_default_init_parameters(&params);
+	error_code = xhptdc8_init(&params);
+	if (XHPTDC8_OK != error_code) {
+		printf("Error initializing the device, %d\n", error_code);
+		return error_code;
+	}
+	xhptdc8_manager_configuration* cfg = new xhptdc8_manager_configuration;
+	xhptdc8_init_configuration(cfg);
+	error_code = xhptdc8_configure(cfg);
+	delete cfg;
+	if (XHPTDC8_OK != error_code) {
+		printf("Error configuring the device, %d\n", error_code);
+		xhptdc8_close();
+		return error_code;
+	}
+
+	vector<TDCHit> hit_buf(hit_buf_size);
+	xhptdc8_readout_stats before;
+	xhptdc8_readout_stats after;
+	long reads = 0;
+	long hits = 0;
+	xhptdc8_start_capture();
+	error_code = get_readout_stats(0, &before);
+	auto end = chrono::steady_clock::now() + chrono::seconds(seconds);
+	while (XHPTDC8_OK == error_code && chrono::steady_clock::now() < end)
+	{
+		int result = xhptdc8_read_hits(hit_buf.data(), hit_buf_size);
+		if (result < 0) {
+			printf("Error reading hits, %d\n", result);
+			error_code = result;
+			break;
+		}
+		reads++;
+		hits += result;
+	}
+	if (XHPTDC8_OK == error_code) {
+		error_code = get_readout_stats(0, &after);
+	}
+	xhptdc8_stop_capture();
+	xhptdc8_close();
+	if (XHPTDC8_OK != error_code) {
+		printf("Error getting the readout statistics, %d\n", error_code);
+		return error_code;
+	}
+
+	// Every hit returned was delivered, and no more hits were delivered than written to the host buffer
+	uint64_t read_calls = after.read_calls - before.read_calls;
+	uint64_t delivered_hits = after.delivered_hits - before.delivered_hits;
+	bool wrong = read_calls != (uint64_t)reads || delivered_hits != (uint64_t)hits ||
+		after.delivered_hits > after.written_hits;
+	printf("%ld reads, %ld hits, read_calls +%llu, delivered_hits +%llu, written_hits %llu: %s\n", reads, hits,
+		(unsigned long long)read_calls, (unsigned long long)delivered_hits, (unsigned long long)after.written_hits,
+		wrong ? "wrong" : "ok");
+	return wrong ? 1 : 0;
+}
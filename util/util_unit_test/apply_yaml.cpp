@@ -12,8 +12,8 @@ namespace apply_yaml
 #define hMgr_INIT_BLOCK \
 	xhptdc8_manager_init_parameters* params = NULL;	\
 	int error_code = xhptdc8_init(params);	\
-	xhptdc8_manager_configuration* cfg = new xhptdc8_manager_configuration;	\
-	xhptdc8_get_default_configuration(cfg);	
+	xhptdc8_manager_configuration* cfg = new xhptdc8_manager_configuration();	\
+	xhptdc8_init_configuration(cfg);	
 
 #define hMgr_CLEANUP_BLOCK \
 		xhptdc8_close();
@@ -847,6 +847,48 @@ namespace apply_yaml
 			Assert::AreEqual(apply_yaml_result,
 				2);
 		}
+		TEST_METHOD(offset_indexed_by_hit_channel)
+		{
+			std::string yaml_string =
+			{
+				"manager_config: \n"
+				" device_configs: \n"
+				"  1: \n"
+				"   channel : \n"
+				"    -1: \n"
+				"     offset : 250\n"
+				"    3: \n"
+				"     offset : -1200\n"
+				"   adc_channel : \n"
+				"    offset : 40\n"
+			};
+			hMgr_INIT_BLOCK;
+			int apply_yaml_result = xhptdc8_apply_yaml(cfg, yaml_string.c_str());
+			Assert::AreEqual(apply_yaml_result, 1);
+			Assert::AreEqual((int64_t)0, cfg->channel_offset[3]);
+			Assert::AreEqual((int64_t)250, cfg->channel_offset[XHPTDC8_NOF_CHANNELS_PER_CARD]);
+			Assert::AreEqual((int64_t)-1200, cfg->channel_offset[XHPTDC8_NOF_CHANNELS_PER_CARD + 3]);
+			Assert::AreEqual((int64_t)250, cfg->channel_offset[XHPTDC8_NOF_CHANNELS_PER_CARD + 7]);
+			Assert::AreEqual((int64_t)40, cfg->channel_offset[XHPTDC8_NOF_CHANNELS_PER_CARD + 8]);
+			Assert::AreEqual((int64_t)40, cfg->channel_offset[XHPTDC8_NOF_CHANNELS_PER_CARD + 9]);
+			delete cfg;
+			hMgr_CLEANUP_BLOCK;
+		}
+		TEST_METHOD(invalid_offset)
+		{
+			std::string yaml_string =
+			{
+				"manager_config: \n"
+				" device_configs: \n"
+				"  0: \n"
+				"   channel : \n"
+				"    0: \n"
+				"     offset : late\n"
+			};
+			int apply_yaml_result = run_xhptdc8_apply_yaml(yaml_string);
+			Assert::AreEqual(apply_yaml_result,
+				XHPTDC8_APPLY_YAML_INVALID_CHANNEL_OFFSET);
+		}
 	};
 	TEST_CLASS(grouping)
 	{
@@ -0,0 +1,93 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "xhptdc8_util.h"
+#include "xhptdc8_interface.h"
+#include <cmath>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace bins_to_ps
+{
+	const double binsize = 1000 / 76.8;
+
+	TEST_CLASS(happy_scenario)
+	{
+	public:
+		TEST_METHOD(rounded_to_ps)
+		{
+			// More values than one AVX-512 register, so the scalar loop converts the rest
+			int64_t bins[] = { 0, 1, 2, -1, -2, 76800, -76800, 768, 77, 1ll << 40, -(1ll << 40) };
+			int64_t ps[11];
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_bins_to_ps(binsize, bins, ps, 11));
+			int64_t expected[] = { 0, 13, 26, -13, -26, 1000000, -1000000, 10000, 1003,
+				14316557653333ll, -14316557653333ll };
+			for (int index = 0; index < 11; index++)
+			{
+				Assert::AreEqual(expected[index], ps[index]);
+			}
+		}
+		TEST_METHOD(largest_times)
+		{
+			// The largest bins whose picoseconds fit into int64_t, the fixed point product must not overflow
+			int64_t bins[] = { 708354972430446749ll, -708354972430446749ll };
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_bins_to_ps(binsize, bins, bins, 2));
+			Assert::AreEqual(9223372036854775797ll, bins[0]);
+			Assert::AreEqual(-9223372036854775797ll, bins[1]);
+		}
+		TEST_METHOD(default_time_unit)
+		{
+			xhptdc8_manager_configuration* mgr_cfg = new xhptdc8_manager_configuration;
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_init_configuration(mgr_cfg));
+			Assert::AreEqual(XHPTDC8_TIME_UNIT_PS, mgr_cfg->time_unit);
+			delete mgr_cfg;
+		}
+		TEST_METHOD(same_as_scalar)
+		{
+			int64_t bins[37];
+			int64_t ps[37];
+			for (int index = 0; index < 37; index++)
+			{
+				bins[index] = (int64_t)index * 1234567 - 7654321;
+			}
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_bins_to_ps(binsize, bins, bins, 37));
+			for (int index = 0; index < 37; index++)
+			{
+				Assert::AreEqual(std::llround(((int64_t)index * 1234567 - 7654321) * binsize), bins[index]);
+			}
+		}
+		TEST_METHOD(hits_in_place)
+		{
+			TDCHit hits[13];
+			for (int index = 0; index < 13; index++)
+			{
+				hits[index].time = index * 76800;
+				hits[index].channel = (uint8_t)index;
+				hits[index].type = XHPTDC8_TDCHIT_TYPE_RISING;
+				hits[index].bin = (uint16_t)(100 + index);
+				hits[index].reserved = 0;
+			}
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_hits_bins_to_ps(binsize, hits, 13));
+			for (int index = 0; index < 13; index++)
+			{
+				Assert::AreEqual((int64_t)index * 1000000, hits[index].time);
+				Assert::AreEqual((uint8_t)index, hits[index].channel);
+				Assert::AreEqual((uint16_t)(100 + index), hits[index].bin);
+			}
+		}
+	};
+
+	TEST_CLASS(error_scenario)
+	{
+	public:
+		TEST_METHOD(invalid_arguments)
+		{
+			int64_t bins[1] = { 1 };
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS, xhptdc8_bins_to_ps(0, bins, bins, 1));
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS, xhptdc8_bins_to_ps(16, bins, bins, 1));
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS, xhptdc8_bins_to_ps(std::nan(""), bins, bins, 1));
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS, xhptdc8_bins_to_ps(binsize, nullptr, bins, 1));
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS, xhptdc8_hits_bins_to_ps(binsize, nullptr, 1));
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_hits_bins_to_ps(binsize, nullptr, 0));
+		}
+	};
+}
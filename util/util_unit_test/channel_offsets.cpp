@@ -0,0 +1,114 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "xhptdc8_util.h"
+#include "xhptdc8_interface.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace channel_offsets
+{
+	void init_config(xhptdc8_manager_configuration* mgr_cfg)
+	{
+		for (int channel = 0; channel < XHPTDC8_CHANNEL_OFFSET_COUNT; channel++)
+		{
+			mgr_cfg->channel_offset[channel] = 0;
+		}
+	}
+
+	void init_hits(TDCHit* hits, int hit_count, int64_t time_step)
+	{
+		for (int index = 0; index < hit_count; index++)
+		{
+			hits[index].time = index * time_step;
+			hits[index].channel = (uint8_t)(index % XHPTDC8_CHANNEL_OFFSET_COUNT);
+			hits[index].type = XHPTDC8_TDCHIT_TYPE_RISING;
+			hits[index].bin = (uint16_t)index;
+			hits[index].reserved = 0;
+		}
+	}
+
+	TEST_CLASS(happy_scenario)
+	{
+	public:
+		TEST_METHOD(order_kept)
+		{
+			// More hits than one AVX-512 block, so the scalar loop corrects the rest
+			xhptdc8_manager_configuration* mgr_cfg = new xhptdc8_manager_configuration;
+			init_config(mgr_cfg);
+			for (int channel = 0; channel < XHPTDC8_CHANNEL_OFFSET_COUNT; channel++)
+			{
+				mgr_cfg->channel_offset[channel] = channel * 10 - 300;
+			}
+			TDCHit hits[21];
+			init_hits(hits, 21, 1000);
+			Assert::AreEqual(0, xhptdc8_apply_channel_offsets(mgr_cfg, -1, hits, 21));
+			for (int index = 0; index < 21; index++)
+			{
+				Assert::AreEqual((int64_t)index * 1000 + index * 10 - 300, hits[index].time);
+				Assert::AreEqual((uint16_t)index, hits[index].bin);
+			}
+			delete mgr_cfg;
+		}
+		TEST_METHOD(resorted)
+		{
+			xhptdc8_manager_configuration* mgr_cfg = new xhptdc8_manager_configuration;
+			init_config(mgr_cfg);
+			// Hit 9 moves before hit 5
+			mgr_cfg->channel_offset[9] = -450;
+			TDCHit hits[12];
+			init_hits(hits, 12, 100);
+			Assert::AreEqual(1, xhptdc8_apply_channel_offsets(mgr_cfg, -1, hits, 12));
+			int expected_channels[] = { 0, 1, 2, 3, 4, 9, 5, 6, 7, 8, 10, 11 };
+			for (int index = 0; index < 12; index++)
+			{
+				Assert::AreEqual((uint8_t)expected_channels[index], hits[index].channel);
+			}
+			Assert::AreEqual((int64_t)450, hits[5].time);
+			delete mgr_cfg;
+		}
+		TEST_METHOD(relative_to_reference)
+		{
+			xhptdc8_manager_configuration* mgr_cfg = new xhptdc8_manager_configuration;
+			init_config(mgr_cfg);
+			mgr_cfg->channel_offset[0] = 500;
+			mgr_cfg->channel_offset[1] = 700;
+			TDCHit hits[2];
+			init_hits(hits, 2, 1000);
+			Assert::AreEqual(0, xhptdc8_apply_channel_offsets(mgr_cfg, 0, hits, 2));
+			Assert::AreEqual((int64_t)0, hits[0].time);
+			Assert::AreEqual((int64_t)1200, hits[1].time);
+			delete mgr_cfg;
+		}
+		TEST_METHOD(channel_without_offset)
+		{
+			xhptdc8_manager_configuration* mgr_cfg = new xhptdc8_manager_configuration;
+			init_config(mgr_cfg);
+			mgr_cfg->channel_offset[XHPTDC8_CHANNEL_OFFSET_COUNT - 1] = 100;
+			TDCHit hits[1];
+			init_hits(hits, 1, 0);
+			hits[0].channel = 255;
+			Assert::AreEqual(0, xhptdc8_apply_channel_offsets(mgr_cfg, -1, hits, 1));
+			Assert::AreEqual((int64_t)0, hits[0].time);
+			delete mgr_cfg;
+		}
+	};
+
+	TEST_CLASS(error_scenario)
+	{
+	public:
+		TEST_METHOD(invalid_arguments)
+		{
+			xhptdc8_manager_configuration* mgr_cfg = new xhptdc8_manager_configuration;
+			init_config(mgr_cfg);
+			TDCHit hits[1];
+			init_hits(hits, 1, 0);
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS, xhptdc8_apply_channel_offsets(nullptr, -1, hits, 1));
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS, xhptdc8_apply_channel_offsets(mgr_cfg, -1, nullptr, 1));
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS, xhptdc8_apply_channel_offsets(mgr_cfg, -2, hits, 1));
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS,
+				xhptdc8_apply_channel_offsets(mgr_cfg, XHPTDC8_CHANNEL_OFFSET_COUNT, hits, 1));
+			Assert::AreEqual(0, xhptdc8_apply_channel_offsets(mgr_cfg, -1, nullptr, 0));
+			delete mgr_cfg;
+		}
+	};
+}
@@ -0,0 +1,128 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "xhptdc8_util.h"
+#include "xhptdc8_interface.h"
+#include <chrono>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace clock_correlation
+{
+	// Polls the fit until it has at least min_samples samples, at most for 2 seconds
+	int wait_for_fit(xhptdc8_clock_correlation* correlation, int host_clock, int min_samples, xhptdc8_clock_fit* fit)
+	{
+		int error_code = XHPTDC8_INSUFFICIENT_DATA;
+		for (int wait_index = 0; wait_index < 200; wait_index++)
+		{
+			error_code = xhptdc8_get_clock_fit(correlation, host_clock, fit);
+			if (XHPTDC8_OK == error_code && fit->sample_count >= min_samples)
+			{
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		return error_code;
+	}
+
+	TEST_CLASS(happy_scenario)
+	{
+	public:
+		TEST_METHOD(board_to_host_ns)
+		{
+			xhptdc8_clock_fit fit = {};
+			fit.board_time = 1000000000;
+			fit.host_time = 5000000;
+			// Board clock 100 ppm slow
+			fit.slope = 0.0010001;
+			int64_t times[] = { 1000000000, 2000000000, 0, 1000000000 + 3600000000000000LL };
+			xhptdc8_board_to_host_ns(&fit, times, times, 4);
+			Assert::AreEqual((int64_t)5000000, times[0]);
+			Assert::AreEqual((int64_t)6000100, times[1]);
+			Assert::AreEqual((int64_t)3999900, times[2]);
+			Assert::AreEqual((int64_t)5000000 + 3600360000000LL, times[3]);
+		}
+		TEST_METHOD(separate_output)
+		{
+			xhptdc8_clock_fit fit = {};
+			fit.slope = 0.001;
+			int64_t board_times[] = { 1000, 2000, 3000 };
+			int64_t host_times[3];
+			xhptdc8_board_to_host_ns(&fit, board_times, host_times, 3);
+			Assert::AreEqual((int64_t)1, host_times[0]);
+			Assert::AreEqual((int64_t)3, host_times[2]);
+			Assert::AreEqual((int64_t)1000, board_times[0]);
+		}
+	};
+
+	// Assumes one and only one card installed on the machine
+	TEST_CLASS(correlate_one_card)
+	{
+	public:
+		TEST_METHOD(fit_and_reset)
+		{
+			xhptdc8_manager_init_parameters params;
+			xhptdc8_get_default_init_parameters(&params);
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_init(&params));
+			xhptdc8_manager_configuration mgr_cfg;
+			xhptdc8_init_configuration(&mgr_cfg);
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_configure(&mgr_cfg));
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_start_capture());
+
+			xhptdc8_clock_correlation* correlation = xhptdc8_start_clock_correlation(0, 20);
+			Assert::IsTrue(nullptr != correlation);
+			// The second sample is taken after 20 ms
+			xhptdc8_clock_fit fit;
+			Assert::AreEqual(XHPTDC8_INSUFFICIENT_DATA,
+				xhptdc8_get_clock_fit(correlation, XHPTDC8_HOST_CLOCK_MONOTONIC, &fit));
+
+			Assert::AreEqual(XHPTDC8_OK, wait_for_fit(correlation, XHPTDC8_HOST_CLOCK_MONOTONIC, 4, &fit));
+			Assert::IsTrue(fit.sample_count >= 2);
+			// The board time of the dummy is derived from the monotonic clock
+			Assert::AreEqual(0.001, fit.slope, 0.00001);
+			int64_t monotonic_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+			xhptdc8_clock_fit realtime_fit;
+			Assert::AreEqual(XHPTDC8_OK,
+				xhptdc8_get_clock_fit(correlation, XHPTDC8_HOST_CLOCK_REALTIME, &realtime_fit));
+			int64_t realtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::system_clock::now().time_since_epoch()).count();
+			Assert::AreEqual(fit.slope, realtime_fit.slope, 0.00001);
+			// Both fits differ by the offset of the host clocks, up to the sampling interval
+			int64_t clock_offset = (realtime_fit.host_time - realtime_fit.board_time / 1000) -
+				(fit.host_time - fit.board_time / 1000);
+			Assert::AreEqual((double)(realtime_ns - monotonic_ns), (double)clock_offset, 100000000.0);
+
+			// Restarting the capture resets the board time, the samples before are discarded
+			int64_t board_time = fit.board_time;
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_stop_capture());
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_start_capture());
+			for (int wait_index = 0; wait_index < 200 && fit.board_time >= board_time; wait_index++)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+				wait_for_fit(correlation, XHPTDC8_HOST_CLOCK_MONOTONIC, 2, &fit);
+			}
+			Assert::IsTrue(fit.board_time < board_time);
+			Assert::AreEqual(0.001, fit.slope, 0.00001);
+
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_stop_clock_correlation(correlation));
+			xhptdc8_stop_capture();
+			xhptdc8_close();
+		}
+	};
+
+	TEST_CLASS(error_scenario)
+	{
+	public:
+		TEST_METHOD(invalid_arguments)
+		{
+			Assert::IsTrue(nullptr == xhptdc8_start_clock_correlation(-1, 10));
+			Assert::IsTrue(nullptr == xhptdc8_start_clock_correlation(XHPTDC8_MANAGER_DEVICES_MAX, 10));
+			Assert::IsTrue(nullptr == xhptdc8_start_clock_correlation(0, 0));
+			xhptdc8_clock_fit fit;
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS,
+				xhptdc8_get_clock_fit(nullptr, XHPTDC8_HOST_CLOCK_MONOTONIC, &fit));
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS, xhptdc8_stop_clock_correlation(nullptr));
+		}
+	};
+}
@@ -0,0 +1,151 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "xhptdc8_util.h"
+#include "xhptdc8_interface.h"
+#include <cstring>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace config_changes
+{
+	xhptdc8_manager_configuration* new_config()
+	{
+		// Zeroed first, so fields without a default compare equal
+		xhptdc8_manager_configuration* mgr_cfg = new xhptdc8_manager_configuration;
+		memset(mgr_cfg, 0, sizeof(xhptdc8_manager_configuration));
+		xhptdc8_init_configuration(mgr_cfg);
+		return mgr_cfg;
+	}
+
+	TEST_CLASS(happy_scenario)
+	{
+	public:
+		TEST_METHOD(unchanged)
+		{
+			xhptdc8_manager_configuration* current = new_config();
+			xhptdc8_manager_configuration* mgr_cfg = new_config();
+			// Only controls how the configuration is applied
+			mgr_cfg->device_configs[0].skip_alignment = true;
+			xhptdc8_config_changes changes;
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_compare_configuration(current, mgr_cfg, &changes));
+			for (int device_index = 0; device_index < XHPTDC8_MANAGER_DEVICES_MAX; device_index++)
+			{
+				Assert::AreEqual(0, changes.device_blocks[device_index]);
+			}
+			Assert::AreEqual(0, changes.manager_blocks);
+			Assert::AreEqual((crono_bool_t)false, changes.configured);
+			Assert::AreEqual(0, changes.aligned_devices);
+			delete current;
+			delete mgr_cfg;
+		}
+		TEST_METHOD(changed_blocks)
+		{
+			xhptdc8_manager_configuration* current = new_config();
+			xhptdc8_manager_configuration* mgr_cfg = new_config();
+			mgr_cfg->device_configs[0].trigger_threshold[3] = -0.2;
+			mgr_cfg->device_configs[1].gating_block[2].stop = 100;
+			mgr_cfg->device_configs[1].channel[4].enable = true;
+			mgr_cfg->channel_offset[12] = 50;
+			xhptdc8_config_changes changes;
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_compare_configuration(current, mgr_cfg, &changes));
+			Assert::AreEqual(XHPTDC8_CONFIG_BLOCK_THRESHOLD, changes.device_blocks[0]);
+			Assert::AreEqual(XHPTDC8_CONFIG_BLOCK_GATING | XHPTDC8_CONFIG_BLOCK_CHANNEL, changes.device_blocks[1]);
+			Assert::AreEqual(0, changes.device_blocks[2]);
+			Assert::AreEqual(XHPTDC8_CONFIG_MANAGER_CHANNEL_OFFSET, changes.manager_blocks);
+			delete current;
+			delete mgr_cfg;
+		}
+		TEST_METHOD(grouping_and_time_unit)
+		{
+			xhptdc8_manager_configuration* current = new_config();
+			xhptdc8_manager_configuration* mgr_cfg = new_config();
+			mgr_cfg->grouping.range_stop = 1000;
+			mgr_cfg->time_unit = XHPTDC8_TIME_UNIT_BINS;
+			xhptdc8_config_changes changes;
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_compare_configuration(current, mgr_cfg, &changes));
+			Assert::AreEqual(XHPTDC8_CONFIG_MANAGER_GROUPING | XHPTDC8_CONFIG_MANAGER_TIME_UNIT,
+				changes.manager_blocks);
+			Assert::AreEqual(0, changes.device_blocks[0]);
+			delete current;
+			delete mgr_cfg;
+		}
+		TEST_METHOD(unreported_members)
+		{
+			// A version 1 driver reports neither the time unit nor the offsets
+			xhptdc8_manager_configuration* current = new_config();
+			current->version = 1;
+			current->time_unit = -1;
+			current->channel_offset[0] = 1234;
+			xhptdc8_manager_configuration* mgr_cfg = new_config();
+			xhptdc8_config_changes changes;
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_compare_configuration(current, mgr_cfg, &changes));
+			Assert::AreEqual(0, changes.manager_blocks);
+			// A version 2 driver reports the time unit only
+			current->version = 2;
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_compare_configuration(current, mgr_cfg, &changes));
+			Assert::AreEqual(XHPTDC8_CONFIG_MANAGER_TIME_UNIT, changes.manager_blocks);
+			delete current;
+			delete mgr_cfg;
+		}
+	};
+
+	// Assumes one and only one card installed on the machine
+	TEST_CLASS(configure_one_card)
+	{
+	public:
+		TEST_METHOD(noop_and_skip_alignment)
+		{
+			xhptdc8_manager_init_parameters params;
+			xhptdc8_get_default_init_parameters(&params);
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_init(&params));
+			xhptdc8_manager_configuration* mgr_cfg = new_config();
+			xhptdc8_config_changes changes;
+
+			// The first configuration applies every block and aligns the board
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_configure_changes(mgr_cfg, &changes));
+			Assert::AreEqual((crono_bool_t)true, changes.configured);
+			Assert::AreEqual(XHPTDC8_CONFIG_BLOCKS_ALL, changes.device_blocks[0]);
+			Assert::AreEqual(1, changes.aligned_devices);
+
+			// Unchanged, the driver is not called
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_configure_changes(mgr_cfg, &changes));
+			Assert::AreEqual((crono_bool_t)false, changes.configured);
+			Assert::AreEqual(0, changes.device_blocks[0]);
+			Assert::AreEqual(0, changes.manager_blocks);
+
+			// A threshold is applied without aligning the board again
+			mgr_cfg->device_configs[0].trigger_threshold[3] = -0.2;
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_configure_changes(mgr_cfg, &changes));
+			Assert::AreEqual((crono_bool_t)true, changes.configured);
+			Assert::AreEqual(XHPTDC8_CONFIG_BLOCK_THRESHOLD, changes.device_blocks[0]);
+			Assert::AreEqual(0, changes.aligned_devices);
+			// The caller's configuration is not modified
+			Assert::AreEqual((crono_bool_t)false, mgr_cfg->device_configs[0].skip_alignment);
+
+			// A channel change needs the alignment
+			mgr_cfg->device_configs[0].channel[4].enable = !mgr_cfg->device_configs[0].channel[4].enable;
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_configure_changes(mgr_cfg, &changes));
+			Assert::AreEqual((crono_bool_t)true, changes.configured);
+			Assert::AreEqual(XHPTDC8_CONFIG_BLOCK_CHANNEL, changes.device_blocks[0]);
+			Assert::AreEqual(1, changes.aligned_devices);
+
+			xhptdc8_close();
+			delete mgr_cfg;
+		}
+	};
+
+	TEST_CLASS(error_scenario)
+	{
+	public:
+		TEST_METHOD(invalid_arguments)
+		{
+			xhptdc8_manager_configuration* mgr_cfg = new_config();
+			xhptdc8_config_changes changes;
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS, xhptdc8_compare_configuration(nullptr, mgr_cfg, &changes));
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS, xhptdc8_compare_configuration(mgr_cfg, nullptr, &changes));
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS, xhptdc8_compare_configuration(mgr_cfg, mgr_cfg, nullptr));
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS, xhptdc8_configure_changes(nullptr, &changes));
+			delete mgr_cfg;
+		}
+	};
+}
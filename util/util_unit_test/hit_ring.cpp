@@ -0,0 +1,110 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "xhptdc8_util.h"
+#include "xhptdc8_interface.h"
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace hit_ring
+{
+	TEST_CLASS(happy_scenario)
+	{
+	public:
+		TEST_METHOD(spsc_fifo_order)
+		{
+			xhptdc8_hit_ring* ring = xhptdc8_create_hit_ring(XHPTDC8_HIT_RING_SPSC, 3, 2);
+			Assert::IsTrue(nullptr != ring);
+			TDCHit hits[2];
+			// 3 batches are rounded up to 4
+			for (int batch_index = 0; batch_index < 4; batch_index++)
+			{
+				hits[0].time = batch_index;
+				Assert::AreEqual(1, xhptdc8_hit_ring_push(ring, hits, 1));
+			}
+			Assert::AreEqual(0, xhptdc8_hit_ring_push(ring, hits, 1));
+			for (int batch_index = 0; batch_index < 4; batch_index++)
+			{
+				Assert::AreEqual(1, xhptdc8_hit_ring_pop(ring, hits, 2));
+				Assert::AreEqual((int64_t)batch_index, hits[0].time);
+			}
+			Assert::AreEqual(-1, xhptdc8_hit_ring_pop(ring, hits, 2));
+			xhptdc8_destroy_hit_ring(ring);
+		}
+		TEST_METHOD(claim_and_acquire)
+		{
+			xhptdc8_hit_ring* ring = xhptdc8_create_hit_ring(XHPTDC8_HIT_RING_MPMC, 2, 4);
+			TDCHit* first = xhptdc8_hit_ring_claim(ring);
+			TDCHit* second = xhptdc8_hit_ring_claim(ring);
+			Assert::IsTrue(nullptr != first && nullptr != second);
+			Assert::IsTrue(nullptr == xhptdc8_hit_ring_claim(ring));
+			second[0].time = 2;
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_hit_ring_commit(ring, second, 1));
+			// The first batch is not committed yet
+			size_t hit_count = 0;
+			Assert::IsTrue(nullptr == xhptdc8_hit_ring_acquire(ring, &hit_count));
+			first[0].time = 1;
+			xhptdc8_hit_ring_commit(ring, first, 4);
+			const TDCHit* batch = xhptdc8_hit_ring_acquire(ring, &hit_count);
+			Assert::IsTrue(first == batch);
+			Assert::AreEqual((size_t)4, hit_count);
+			Assert::AreEqual(XHPTDC8_OK, xhptdc8_hit_ring_release(ring, batch));
+			Assert::IsTrue(nullptr != xhptdc8_hit_ring_claim(ring));
+			xhptdc8_destroy_hit_ring(ring);
+		}
+		TEST_METHOD(mpmc_threads)
+		{
+			const int batches_per_producer = 10000;
+			xhptdc8_hit_ring* ring = xhptdc8_create_hit_ring(XHPTDC8_HIT_RING_MPMC, 8, 1);
+			std::thread producers[2];
+			for (std::thread& producer : producers)
+			{
+				producer = std::thread([ring] {
+					TDCHit hit;
+					for (int batch_index = 1; batch_index <= batches_per_producer; batch_index++)
+					{
+						hit.time = batch_index;
+						while (0 == xhptdc8_hit_ring_push(ring, &hit, 1))
+						{
+							std::this_thread::yield();
+						}
+					}
+				});
+			}
+			int64_t sum = 0;
+			for (int batch_index = 0; batch_index < 2 * batches_per_producer; batch_index++)
+			{
+				TDCHit hit;
+				while (xhptdc8_hit_ring_pop(ring, &hit, 1) < 0)
+				{
+					std::this_thread::yield();
+				}
+				sum += hit.time;
+			}
+			for (std::thread& producer : producers)
+			{
+				producer.join();
+			}
+			Assert::AreEqual((int64_t)batches_per_producer * (batches_per_producer + 1), sum);
+			xhptdc8_destroy_hit_ring(ring);
+		}
+	};
+
+	TEST_CLASS(error_scenario)
+	{
+	public:
+		TEST_METHOD(invalid_arguments)
+		{
+			Assert::IsTrue(nullptr == xhptdc8_create_hit_ring(2, 4, 4));
+			Assert::IsTrue(nullptr == xhptdc8_create_hit_ring(XHPTDC8_HIT_RING_SPSC, 0, 4));
+			xhptdc8_hit_ring* ring = xhptdc8_create_hit_ring(XHPTDC8_HIT_RING_SPSC, 4, 4);
+			TDCHit hits[5];
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS, xhptdc8_hit_ring_push(ring, hits, 5));
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS, xhptdc8_hit_ring_pop(ring, hits, 3));
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS, xhptdc8_hit_ring_commit(ring, hits, 1));
+			Assert::IsTrue(nullptr == xhptdc8_start_async_capture(nullptr, 0));
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS, xhptdc8_stop_async_capture(nullptr, nullptr));
+			xhptdc8_destroy_hit_ring(ring);
+		}
+	};
+}
@@ -0,0 +1,91 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "xhptdc8_util.h"
+#include "xhptdc8_interface.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace merge_hits
+{
+	static TDCHit make_hit(int board, int64_t time)
+	{
+		TDCHit hit = {};
+		hit.time = time;
+		hit.channel = (uint8_t)(board * XHPTDC8_NOF_CHANNELS_PER_CARD + 1);
+		return hit;
+	}
+
+	TEST_CLASS(happy_scenario)
+	{
+	public:
+		TEST_METHOD(sorted_by_time)
+		{
+			xhptdc8_merger* merger = xhptdc8_create_merger(3, 1000);
+			Assert::IsTrue(nullptr != merger);
+			TDCHit hits[] = { make_hit(2, 5), make_hit(0, 10), make_hit(1, 1), make_hit(2, 20),
+				make_hit(0, 30), make_hit(1, 40), make_hit(1, 50) };
+			Assert::AreEqual(7, xhptdc8_merger_push(merger, hits, 7));
+			TDCHit merged[7];
+			int merged_count = xhptdc8_merger_pop(merger, merged, 7, false);
+			// Hits up to the last hit of the slowest board are merged
+			Assert::AreEqual(4, merged_count);
+			int64_t expected[] = { 1, 5, 10, 20 };
+			for (int hit_index = 0; hit_index < merged_count; hit_index++)
+			{
+				Assert::AreEqual(expected[hit_index], merged[hit_index].time);
+			}
+			Assert::AreEqual(3, xhptdc8_merger_pop(merger, merged, 7, true));
+			Assert::AreEqual((int64_t)30, merged[0].time);
+			Assert::AreEqual((int64_t)50, merged[2].time);
+			xhptdc8_destroy_merger(merger);
+		}
+		TEST_METHOD(latency_bound)
+		{
+			xhptdc8_merger* merger = xhptdc8_create_merger(2, 100);
+			TDCHit hits[] = { make_hit(0, 10), make_hit(0, 50), make_hit(0, 200) };
+			xhptdc8_merger_push(merger, hits, 3);
+			TDCHit merged[3];
+			// Board 1 can still deliver hits from 100 on
+			Assert::AreEqual(2, xhptdc8_merger_pop(merger, merged, 3, false));
+			Assert::AreEqual((int64_t)50, merged[1].time);
+			Assert::AreEqual(0, xhptdc8_merger_pop(merger, merged, 3, false));
+			TDCHit late = make_hit(1, 150);
+			xhptdc8_merger_push(merger, &late, 1);
+			Assert::AreEqual(1, xhptdc8_merger_pop(merger, merged, 3, false));
+			Assert::AreEqual((int64_t)150, merged[0].time);
+			xhptdc8_destroy_merger(merger);
+		}
+		TEST_METHOD(equal_times_and_partial_pop)
+		{
+			xhptdc8_merger* merger = xhptdc8_create_merger(2, 0);
+			TDCHit hits[] = { make_hit(1, 7), make_hit(0, 7), make_hit(0, 8), make_hit(1, 9) };
+			xhptdc8_merger_push(merger, hits, 4);
+			TDCHit merged[4];
+			Assert::AreEqual(1, xhptdc8_merger_pop(merger, merged, 1, true));
+			Assert::AreEqual(0, merged[0].channel / XHPTDC8_NOF_CHANNELS_PER_CARD);
+			Assert::AreEqual(3, xhptdc8_merger_pop(merger, merged, 4, true));
+			Assert::AreEqual(1, merged[0].channel / XHPTDC8_NOF_CHANNELS_PER_CARD);
+			Assert::AreEqual((int64_t)8, merged[1].time);
+			Assert::AreEqual((int64_t)9, merged[2].time);
+			xhptdc8_destroy_merger(merger);
+		}
+	};
+
+	TEST_CLASS(error_scenario)
+	{
+	public:
+		TEST_METHOD(invalid_arguments)
+		{
+			Assert::IsTrue(nullptr == xhptdc8_create_merger(0, 0));
+			Assert::IsTrue(nullptr == xhptdc8_create_merger(XHPTDC8_MANAGER_DEVICES_MAX + 1, 0));
+			Assert::IsTrue(nullptr == xhptdc8_create_merger(2, -1));
+			xhptdc8_merger* merger = xhptdc8_create_merger(2, 0);
+			TDCHit hit = make_hit(2, 0);
+			// Board 2 is not merged
+			Assert::AreEqual(0, xhptdc8_merger_push(merger, &hit, 1));
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS, xhptdc8_merger_push(nullptr, &hit, 1));
+			Assert::AreEqual(XHPTDC8_INVALID_ARGUMENTS, xhptdc8_merger_pop(merger, nullptr, 1, false));
+			xhptdc8_destroy_merger(merger);
+		}
+	};
+}
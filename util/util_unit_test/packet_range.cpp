@@ -0,0 +1,88 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "xhptdc8_util.h"
+#include "xhptdc8_interface.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace packet_range
+{
+	// Writes a TDC data packet of `length` hits at `words`, returns the number of words written
+	size_t write_packet(uint64_t* words, int64_t timestamp, uint32_t length)
+	{
+		crono_packet* packet = (crono_packet*)words;
+		packet->channel = 0;
+		packet->card = 0;
+		packet->type = CRONO_PACKET_TYPE_TDC_DATA;
+		packet->flags = 0;
+		packet->length = length;
+		packet->timestamp = timestamp;
+		for (uint32_t hit_index = 0; hit_index < length; hit_index++)
+		{
+			packet->data[hit_index] = XHPTDC8_PACKED_HIT(hit_index, XHPTDC8_TDCHIT_TYPE_RISING, 0, hit_index * 100);
+		}
+		return 2 + length;
+	}
+
+	TEST_CLASS(happy_scenario)
+	{
+	public:
+		TEST_METHOD(first_to_last_packet)
+		{
+			uint64_t words[16];
+			size_t second = write_packet(words, 1000, 3);
+			size_t third = second + write_packet(words + second, 2000, 0);
+			write_packet(words + third, 3000, 2);
+
+			int packet_count = 0;
+			int hit_count = 0;
+			xhptdc8_packet_range range((crono_packet*)words, (crono_packet*)(words + third));
+			for (const crono_packet& packet : range)
+			{
+				TDCHit hits[4];
+				hit_count += xhptdc8_unpack_packet(&packet, hits, 4);
+				packet_count++;
+			}
+			Assert::AreEqual(3, packet_count);
+			Assert::AreEqual(5, hit_count);
+		}
+		TEST_METHOD(unpack_packet)
+		{
+			uint64_t words[8];
+			write_packet(words, 1000, 3);
+			TDCHit hits[4];
+			Assert::AreEqual(3, xhptdc8_unpack_packet((crono_packet*)words, hits, 4));
+			Assert::AreEqual((int64_t)1200, hits[2].time);
+			Assert::AreEqual((uint8_t)2, hits[2].channel);
+		}
+	};
+
+	TEST_CLASS(error_scenario)
+	{
+	public:
+		TEST_METHOD(truncated_packet)
+		{
+			uint64_t words[16];
+			size_t second = write_packet(words, 1000, 3);
+			size_t end = second + write_packet(words + second, 2000, 5);
+
+			// The second packet exceeds the range by one word
+			int packet_count = 0;
+			for (const crono_packet& packet : xhptdc8_packet_range(words, (end - 1) * sizeof(uint64_t)))
+			{
+				Assert::AreEqual((int64_t)1000, packet.timestamp);
+				packet_count++;
+			}
+			Assert::AreEqual(1, packet_count);
+		}
+		TEST_METHOD(empty_range)
+		{
+			int packet_count = 0;
+			for (const crono_packet& packet : xhptdc8_packet_range((crono_packet*)NULL, (crono_packet*)NULL))
+			{
+				packet_count++;
+			}
+			Assert::AreEqual(0, packet_count);
+		}
+	};
+};
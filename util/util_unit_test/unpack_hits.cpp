@@ -0,0 +1,62 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "xhptdc8_util.h"
+#include "xhptdc8_interface.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unpack_hits
+{
+	TEST_CLASS(happy_scenario)
+	{
+	public:
+		TEST_METHOD(anchor_and_deltas)
+		{
+			uint64_t words[] = {
+				XHPTDC8_PACKED_ANCHOR(1000000000000LL),
+				XHPTDC8_PACKED_HIT(0, XHPTDC8_TDCHIT_TYPE_RISING, 0, 0),
+				XHPTDC8_PACKED_HIT(1, XHPTDC8_TDCHIT_TYPE_RISING, 7, 5000),
+				XHPTDC8_PACKED_ANCHOR(999999999000LL),
+				XHPTDC8_PACKED_HIT(59, XHPTDC8_TDCHIT_TYPE_ERROR, 0xFFFF, 0xFFFFFFFF)
+			};
+			TDCHit hits[5];
+			int hit_count = xhptdc8_unpack_hits(words, 5, hits, 5);
+			Assert::AreEqual(3, hit_count);
+			Assert::AreEqual((int64_t)1000000000000LL, hits[0].time);
+			Assert::AreEqual((int64_t)1000000005000LL, hits[1].time);
+			Assert::AreEqual((uint8_t)1, hits[1].channel);
+			Assert::AreEqual((uint16_t)7, hits[1].bin);
+			Assert::AreEqual((int64_t)(999999999000LL + 0xFFFFFFFFLL), hits[2].time);
+			Assert::AreEqual((uint8_t)59, hits[2].channel);
+			Assert::AreEqual((uint8_t)XHPTDC8_TDCHIT_TYPE_ERROR, hits[2].type);
+			Assert::AreEqual((uint16_t)0xFFFF, hits[2].bin);
+		}
+		TEST_METHOD(hit_buf_full)
+		{
+			uint64_t words[] = {
+				XHPTDC8_PACKED_ANCHOR(0),
+				XHPTDC8_PACKED_HIT(0, XHPTDC8_TDCHIT_TYPE_RISING, 0, 10),
+				XHPTDC8_PACKED_HIT(1, XHPTDC8_TDCHIT_TYPE_RISING, 0, 10)
+			};
+			TDCHit hits[1];
+			Assert::AreEqual(1, xhptdc8_unpack_hits(words, 3, hits, 1));
+			Assert::AreEqual((int64_t)10, hits[0].time);
+		}
+	};
+
+	TEST_CLASS(error_scenario)
+	{
+	public:
+		TEST_METHOD(missing_anchor)
+		{
+			uint64_t words[] = { XHPTDC8_PACKED_HIT(0, XHPTDC8_TDCHIT_TYPE_RISING, 0, 10) };
+			TDCHit hits[1];
+			Assert::AreEqual(-1, xhptdc8_unpack_hits(words, 1, hits, 1));
+		}
+		TEST_METHOD(null_buffers)
+		{
+			TDCHit hits[1];
+			Assert::AreEqual(-1, xhptdc8_unpack_hits(NULL, 1, hits, 1));
+		}
+	};
+};